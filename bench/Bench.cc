@@ -0,0 +1,109 @@
+#include "Bench.h"
+#include "JsonWriter.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <iostream>
+#include <cstdio>
+
+BenchRunner::BenchRunner(const string& filter, int targetMs, int rounds)
+    : _filter(filter)
+    , _targetMs(std::max(targetMs, 1))
+    , _rounds(std::max(rounds, 1)) {
+}
+
+bool BenchRunner::enabled(const string& name) const {
+    return _filter.empty() || name.find(_filter) != string::npos;
+}
+
+double BenchRunner::timeRound(const Body& body, uint64_t n, int threads) {
+    if (threads <= 1) {
+        auto start = std::chrono::steady_clock::now();
+        body(n, 0);
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // 所有线程就绪后同时开始，计时覆盖从放行到最后一个线程结束
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            body(n, t);
+        });
+    }
+    while (ready.load() < threads) {
+        std::this_thread::yield();
+    }
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+void BenchRunner::run(const string& name, const Body& body, int threads) {
+    if (!enabled(name)) {
+        return;
+    }
+    threads = std::max(threads, 1);
+
+    // 标定：迭代次数逐次放大，直到单轮超过 10ms，再按比例推算到目标时长
+    double targetNs = _targetMs * 1e6;
+    uint64_t n = 1;
+    double elapsed = timeRound(body, n, threads);
+    while (elapsed < 1e7 && n < (1ULL << 40)) {
+        n *= 10;
+        elapsed = timeRound(body, n, threads);
+    }
+    n = std::max<uint64_t>(1, (uint64_t)(n * targetNs / std::max(elapsed, 1.0)));
+
+    vector<double> perOp;
+    for (int r = 0; r < _rounds; ++r) {
+        perOp.push_back(timeRound(body, n, threads) / ((double)n * threads));
+    }
+    std::sort(perOp.begin(), perOp.end());
+
+    BenchResult result;
+    result.name = name;
+    result.threads = threads;
+    result.iterations = n;
+    result.nsPerOp = perOp[perOp.size() / 2];
+    result.minNsPerOp = perOp.front();
+    result.maxNsPerOp = perOp.back();
+    result.opsPerSec = result.nsPerOp > 0 ? 1e9 / result.nsPerOp : 0;
+    _results.push_back(result);
+
+    char line[256];
+    snprintf(line, sizeof(line), "%-40s %2d thr %12.1f ns/op %14.0f ops/s\n",
+             name.c_str(), threads, result.nsPerOp, result.opsPerSec);
+    std::cerr << line;
+}
+
+void BenchRunner::writeJson(std::ostream& os, const string& context) const {
+    string out;
+    JsonWriter writer(out);
+    writer.beginObject();
+    writer.key("context").raw(context);
+    writer.key("benchmarks").beginArray();
+    for (const auto& result : _results) {
+        writer.beginObject();
+        writer.key("name").value(result.name);
+        writer.key("threads").value(result.threads);
+        writer.key("iterations").value((size_t)result.iterations);
+        writer.key("ns_per_op").value(result.nsPerOp);
+        writer.key("min_ns_per_op").value(result.minNsPerOp);
+        writer.key("max_ns_per_op").value(result.maxNsPerOp);
+        writer.key("ops_per_sec").value(result.opsPerSec);
+        writer.endObject();
+    }
+    writer.endArray();
+    writer.endObject();
+    os << out << '\n';
+}
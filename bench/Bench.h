@@ -0,0 +1,58 @@
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <ostream>
+#include <cstdint>
+
+using std::string;
+using std::vector;
+
+// 阻止编译器把结果未被使用的计算优化掉
+template<typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// 单个基准的结果
+struct BenchResult {
+    string name;
+    int threads = 1;
+    uint64_t iterations = 0;    // 每轮每线程执行次数
+    double nsPerOp = 0;         // 各轮中位数（多线程时为墙上时间 / 总操作数）
+    double minNsPerOp = 0;
+    double maxNsPerOp = 0;
+    double opsPerSec = 0;       // 所有线程合计吞吐
+};
+
+// 微基准运行器：自动标定迭代次数，使每轮耗时约 targetMs，重复 rounds 轮取中位数
+class BenchRunner {
+public:
+    // filter 非空时只运行名字中包含该子串的基准
+    explicit BenchRunner(const string& filter = "", int targetMs = 200, int rounds = 5);
+
+    // body(n) 执行 n 次被测操作；threads > 1 时在多个线程上同时执行，threadIndex 区分线程
+    using Body = std::function<void(uint64_t n, int threadIndex)>;
+    void run(const string& name, const Body& body, int threads = 1);
+
+    bool enabled(const string& name) const;
+
+    const vector<BenchResult>& results() const { return _results; }
+
+    // 以 JSON 输出全部结果，context 为附加的运行环境信息（已是合法 JSON 对象）
+    void writeJson(std::ostream& os, const string& context) const;
+
+private:
+    // 执行一轮，返回墙上耗时（纳秒）
+    static double timeRound(const Body& body, uint64_t n, int threads);
+
+private:
+    string _filter;
+    int _targetMs;
+    int _rounds;
+    vector<BenchResult> _results;
+};
+
+#endif // __BENCH_H__
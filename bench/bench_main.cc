@@ -0,0 +1,309 @@
+// 核心算子微基准：make bench 运行，结果以 JSON 写入 bench_result.json（或第一个参数指定的文件，"-" 为标准输出）
+// 第二个参数为名字过滤子串，例如 ./search_bench - index.search
+// 使用固定种子的合成语料与空格分词，不依赖外部数据和结巴词典，结果可跨机器、跨版本对比
+
+#include "Bench.h"
+#include "SplitTool.h"
+#include "WebPage.h"
+#include "InvertIndex.h"
+#include "LRUCache.h"
+#include "DictProducer.h"
+#include "KeywordRecommender.h"
+#include "ContentStore.h"
+#include "JsonWriter.h"
+#include "Logger.h"
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <memory>
+#include <algorithm>
+#include <unistd.h>
+
+using std::shared_ptr;
+using std::make_shared;
+
+static const uint64_t SEED = 20240601;
+static const size_t CORPUS_DOCS = 20000;
+static const size_t VOCAB_SIZE = 20000;
+
+// 按空格切分，丢弃句号（合成语料中词之间以空格分隔）
+class WhitespaceSplitTool : public SplitTool {
+public:
+    vector<string> cut(const string& sentence) override {
+        vector<string> words;
+        size_t pos = 0;
+        while (pos < sentence.size()) {
+            size_t end = sentence.find(' ', pos);
+            if (end == string::npos) end = sentence.size();
+            if (end > pos && sentence.compare(pos, end - pos, "。") != 0) {
+                words.emplace_back(sentence, pos, end - pos);
+            }
+            pos = end + 1;
+        }
+        return words;
+    }
+};
+
+// 合成语料：词表为 1~4 个随机汉字，词频服从 Zipf 分布
+struct BenchCorpus {
+    vector<string> vocab;       // 按频率降序
+    vector<string> docs;        // <doc> XML
+    vector<string> contents;    // 与 docs 对应的正文
+};
+
+static void appendCodepoint(string& out, uint32_t cp) {
+    out += (char)(0xE0 | (cp >> 12));
+    out += (char)(0x80 | ((cp >> 6) & 0x3F));
+    out += (char)(0x80 | (cp & 0x3F));
+}
+
+static BenchCorpus makeCorpus(size_t docCount, size_t vocabSize, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    BenchCorpus corpus;
+
+    std::uniform_int_distribution<uint32_t> hanzi(0x4E00, 0x6FFF);
+    std::uniform_int_distribution<int> wordLen(1, 4);
+    corpus.vocab.reserve(vocabSize);
+    for (size_t i = 0; i < vocabSize; ++i) {
+        string word;
+        int len = wordLen(rng);
+        for (int c = 0; c < len; ++c) {
+            appendCodepoint(word, hanzi(rng));
+        }
+        corpus.vocab.push_back(word);
+    }
+
+    vector<double> cdf(vocabSize);
+    double sum = 0;
+    for (size_t i = 0; i < vocabSize; ++i) {
+        sum += 1.0 / (i + 1);
+        cdf[i] = sum;
+    }
+    std::uniform_real_distribution<double> uniform(0, sum);
+    auto zipfWord = [&]() -> const string& {
+        size_t rank = std::upper_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+        return corpus.vocab[std::min(rank, vocabSize - 1)];
+    };
+
+    std::uniform_int_distribution<int> docLen(80, 400);
+    for (size_t d = 0; d < docCount; ++d) {
+        string title;
+        for (int i = 0; i < 5; ++i) {
+            if (i) title += ' ';
+            title += zipfWord();
+        }
+        string content;
+        int words = docLen(rng);
+        for (int i = 0; i < words; ++i) {
+            content += zipfWord();
+            content += (i % 12 == 11) ? " 。 " : " ";
+        }
+        corpus.docs.push_back("<doc><docid>" + std::to_string(d + 1) + "</docid><url>http://bench.local/"
+                              + std::to_string(d + 1) + "</url><title>" + title + "</title><content>"
+                              + content + "</content></doc>");
+        corpus.contents.push_back(std::move(content));
+    }
+    return corpus;
+}
+
+// 线程私有的 xorshift 随机数，基准循环内不引入锁和分布对象
+static inline uint64_t nextRandom(uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static void benchIndex(BenchRunner& runner, InvertIndex& index, const BenchCorpus& corpus, const string& prefix) {
+    const auto& v = corpus.vocab;
+    vector<pair<string, vector<string>>> shapes = {
+        {"single_common", {v[0]}},
+        {"single_rare", {v[v.size() / 2]}},
+        {"two_common", {v[1], v[2]}},
+        {"common_rare", {v[3], v[v.size() / 3]}},
+        {"mixed_4", {v[0], v[10], v[300], v[5000]}},
+        {"long_8", {v[1], v[5], v[20], v[50], v[100], v[500], v[1000], v[8000]}},
+    };
+    for (const auto& shape : shapes) {
+        const vector<string>& query = shape.second;
+        runner.run(prefix + shape.first, [&](uint64_t n, int) {
+            for (uint64_t i = 0; i < n; ++i) {
+                auto results = index.search(query);
+                doNotOptimize(results);
+            }
+        });
+    }
+}
+
+static void benchCache(BenchRunner& runner) {
+    const size_t capacity = 10000;
+    const size_t keySpace = 20000;
+    vector<string> keys;
+    for (size_t i = 0; i < keySpace; ++i) {
+        keys.push_back("query-" + std::to_string(i * 2654435761ULL));
+    }
+    string value(512, 'x');
+
+    vector<int> threadCounts = {1, 4};
+    int hardware = (int)std::max(1u, std::thread::hardware_concurrency());
+    if (hardware > 4) threadCounts.push_back(hardware);
+
+    for (int threads : threadCounts) {
+        SearchCache cache(capacity);
+        for (size_t i = 0; i < capacity; ++i) {
+            cache.put(keys[i], value);
+        }
+        // 90% 读 10% 写
+        runner.run("lru.get90_put10", [&](uint64_t n, int t) {
+            uint64_t state = 0x9E3779B97F4A7C15ULL * (t + 1);
+            string out;
+            for (uint64_t i = 0; i < n; ++i) {
+                uint64_t r = nextRandom(state);
+                const string& key = keys[r % keySpace];
+                if ((r >> 32) % 10 == 0) {
+                    cache.put(key, value);
+                } else {
+                    doNotOptimize(cache.get(key, out));
+                }
+            }
+        }, threads);
+    }
+}
+
+static void benchRecommender(BenchRunner& runner, const vector<shared_ptr<WebPage>>& pages,
+                             const BenchCorpus& corpus, WhitespaceSplitTool& splitTool) {
+    runner.run("recommender.edit_distance.ascii", [](uint64_t n, int) {
+        for (uint64_t i = 0; i < n; ++i) {
+            doNotOptimize(KeywordRecommender::editDistance("recommendation", "recomendations"));
+        }
+    });
+    const string& a = corpus.vocab[7];
+    const string& b = corpus.vocab[8];
+    runner.run("recommender.edit_distance.cjk", [&](uint64_t n, int) {
+        for (uint64_t i = 0; i < n; ++i) {
+            doNotOptimize(KeywordRecommender::editDistance(a, b));
+        }
+    });
+
+    if (!runner.enabled("recommender.recommend")) {
+        return;
+    }
+    DictProducer dict(&splitTool);
+    dict.build(pages);
+    KeywordRecommender recommender(&dict);
+    const string& query = corpus.vocab[42];
+    runner.run("recommender.recommend", [&](uint64_t n, int) {
+        for (uint64_t i = 0; i < n; ++i) {
+            auto words = recommender.recommend(query);
+            doNotOptimize(words);
+        }
+    });
+}
+
+static void benchWebPage(BenchRunner& runner, const vector<shared_ptr<WebPage>>& pages,
+                         const BenchCorpus& corpus, WhitespaceSplitTool& splitTool) {
+    runner.run("webpage.simhash", [&](uint64_t n, int) {
+        for (uint64_t i = 0; i < n; ++i) {
+            doNotOptimize(pages[i % pages.size()]->getSimhash());
+        }
+    });
+    runner.run("webpage.extract_fields", [&](uint64_t n, int) {
+        for (uint64_t i = 0; i < n; ++i) {
+            auto fields = WebPage::extractFields(corpus.docs[i % corpus.docs.size()]);
+            doNotOptimize(fields);
+        }
+    });
+    runner.run("webpage.process_doc", [&](uint64_t n, int) {
+        for (uint64_t i = 0; i < n; ++i) {
+            WebPage page(corpus.docs[i % corpus.docs.size()], &splitTool);
+            doNotOptimize(page);
+        }
+    });
+}
+
+static void benchContentStore(BenchRunner& runner, const BenchCorpus& corpus) {
+    if (!runner.enabled("content_store")) {
+        return;
+    }
+    char path[] = "/tmp/search_bench_contentXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        std::cerr << "Cannot create temporary content file, skipping content_store\n";
+        return;
+    }
+    close(fd);
+
+    vector<pair<size_t, size_t>> spans;
+    {
+        std::ofstream ofs(path, std::ios::binary);
+        size_t offset = 0;
+        for (const auto& content : corpus.contents) {
+            ofs << content;
+            spans.emplace_back(offset, content.size());
+            offset += content.size();
+        }
+    }
+
+    vector<string> query = {corpus.vocab[3], corpus.vocab[40]};
+    for (bool mapped : {true, false}) {
+        ContentStore store(path, mapped ? ContentStore::DEFAULT_MMAP_LIMIT : 0);
+        runner.run(mapped ? "content_store.get_summary.mmap" : "content_store.get_summary.pread",
+                   [&](uint64_t n, int) {
+            for (uint64_t i = 0; i < n; ++i) {
+                const auto& span = spans[i % spans.size()];
+                doNotOptimize(store.getSummary(span.first, span.second, query));
+            }
+        });
+    }
+    unlink(path);
+}
+
+int main(int argc, char* argv[]) {
+    string outPath = argc > 1 ? argv[1] : "bench_result.json";
+    string filter = argc > 2 ? argv[2] : "";
+
+    Logger::getInstance()->init("conf/log4cpp.properties");
+    BenchRunner runner(filter);
+
+    std::cerr << "Generating corpus: " << CORPUS_DOCS << " docs, " << VOCAB_SIZE << " words\n";
+    BenchCorpus corpus = makeCorpus(CORPUS_DOCS, VOCAB_SIZE, SEED);
+    WhitespaceSplitTool splitTool;
+
+    vector<shared_ptr<WebPage>> pages;
+    pages.reserve(corpus.docs.size());
+    for (const auto& doc : corpus.docs) {
+        pages.push_back(make_shared<WebPage>(doc, &splitTool));
+    }
+
+    InvertIndex index;
+    index.build(pages);
+    benchIndex(runner, index, corpus, "index.search.");
+    // 热词缓存：准入阈值 1，首次查询即构建条目，计时部分全部走阈值算法
+    index.enableTermCache(512, 1024, 1, 1000, 256);
+    benchIndex(runner, index, corpus, "index.search_termcache.");
+
+    benchCache(runner);
+    benchRecommender(runner, pages, corpus, splitTool);
+    benchWebPage(runner, pages, corpus, splitTool);
+    benchContentStore(runner, corpus);
+
+    string context;
+    JsonWriter writer(context);
+    writer.beginObject();
+    writer.key("docs").value(CORPUS_DOCS);
+    writer.key("vocab").value(VOCAB_SIZE);
+    writer.key("seed").value((size_t)SEED);
+    writer.key("compiler").value(__VERSION__);
+    writer.key("hardware_threads").value((int)std::thread::hardware_concurrency());
+    writer.endObject();
+
+    if (outPath == "-") {
+        runner.writeJson(std::cout, context);
+    } else {
+        std::ofstream ofs(outPath);
+        runner.writeJson(ofs, context);
+        std::cerr << "Results written to " << outPath << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+#ifndef __ADMISSION_CONTROLLER_H__
+#define __ADMISSION_CONTROLLER_H__
+
+#include <atomic>
+#include <cstdint>
+
+// 准入控制：限制同时处理的搜索请求数，并按服务时间估计预测排队等待
+// 过载时分三级处理：
+//   在途请求未达并发上限      -> 正常处理
+//   已饱和但预计仍能按期完成  -> 降级（只返回标题，跳过摘要）
+//   预计超出请求截止时间      -> 只服务缓存命中，未命中直接 503
+class AdmissionController {
+public:
+    enum Decision {
+        ADMIT,
+        DEGRADE,
+        REJECT
+    };
+
+    // maxConcurrent: 并发上限，一般取计算线程数
+    // maxQueue: 饱和后允许额外排队的请求数，超过时不论截止时间一律拒绝
+    AdmissionController(int maxConcurrent, int maxQueue);
+
+    // 判断是否接纳一个截止时间为 deadlineUs（相对当前）的请求
+    // 返回 ADMIT/DEGRADE 时已占用一个名额，处理结束后必须调用 release
+    Decision admit(int64_t deadlineUs);
+
+    // 请求开始在计算线程上执行时调用，记录排队耗时（参与等待时间的估计）
+    void recordQueueTime(int64_t queueUs);
+
+    // 请求处理完成，归还名额；recordService 为 true 时 serviceUs 计入服务时间估计。
+    // 只有完整处理的单次查询才应计入：降级请求更快会拉低估计，批量请求的耗时不代表单次查询
+    void release(int64_t serviceUs, bool recordService);
+
+    // 估算新请求的完成耗时：自身服务时间 + 等待时间
+    // 等待时间取按在途请求数推算的值与实测排队耗时的较大者，后者能反映计算队列中其他任务造成的等待
+    int64_t expectedLatencyUs() const;
+
+    int inflight() const { return _inflight.load(std::memory_order_relaxed); }
+    int64_t serviceTimeUs() const { return _serviceEwmaUs.load(std::memory_order_relaxed); }
+    int64_t queueTimeUs() const { return _queueEwmaUs.load(std::memory_order_relaxed); }
+    uint64_t admittedCount() const { return _admitted.load(std::memory_order_relaxed); }
+    uint64_t degradedCount() const { return _degraded.load(std::memory_order_relaxed); }
+    uint64_t rejectedCount() const { return _rejected.load(std::memory_order_relaxed); }
+
+private:
+    int64_t expectedLatencyUs(int inflight) const;
+
+    // 指数加权移动平均，权重 1/8；并发更新偶有丢失无妨
+    static void updateEwma(std::atomic<int64_t>& ewma, int64_t sample);
+
+private:
+    int _maxConcurrent;
+    int _maxQueue;
+
+    std::atomic<int> _inflight{0};
+    std::atomic<int64_t> _serviceEwmaUs{0};
+    std::atomic<int64_t> _queueEwmaUs{0};
+
+    std::atomic<uint64_t> _admitted{0};
+    std::atomic<uint64_t> _degraded{0};
+    std::atomic<uint64_t> _rejected{0};
+};
+
+#endif // __ADMISSION_CONTROLLER_H__
@@ -0,0 +1,81 @@
+#ifndef __BUILD_PROFILER_H__
+#define __BUILD_PROFILER_H__
+
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+using std::string;
+
+// 索引构建阶段
+enum BuildPhase {
+    PHASE_READ = 0,     // 读取语料文件（mmap 读入时只含映射本身，读盘以缺页形式计入 extract）
+    PHASE_EXTRACT,      // 切分 <doc> 块并抽取标题 / URL / 正文
+    PHASE_TOKENIZE,     // 分句、分词与词频统计
+    PHASE_DEDUP,        // SimHash 去重
+    PHASE_INVERT,       // 构建倒排索引
+    PHASE_DICT,         // 构建推荐词典
+    PHASE_STORE,        // 写出索引、词典与网页库
+    PHASE_COUNT
+};
+
+// 构建过程剖析：各阶段累计耗时、吞吐与峰值内存，构建结束时输出日志并写出 JSON
+// 阶段可能交错执行（读文件与逐篇解析交替进行），因此按阶段累加耗时，未计入任何阶段的部分记为 other
+class BuildProfiler {
+public:
+    static BuildProfiler* getInstance();
+
+    // 开始计时（墙上时间从这里算起），并清空已有统计
+    void begin();
+
+    void add(BuildPhase phase, int64_t ns) {
+        _phaseNs[phase].fetch_add(ns, std::memory_order_relaxed);
+    }
+    void addInputBytes(size_t bytes) { _inputBytes.fetch_add(bytes, std::memory_order_relaxed); }
+    void addInputDocs(size_t docs) { _inputDocs.fetch_add(docs, std::memory_order_relaxed); }
+    void setIndexedDocs(size_t docs) { _indexedDocs = docs; }
+    // 语料通过 mmap 读入：报告中注明 read 与 extract 交错
+    void setMappedInput() { _mappedInput.store(true, std::memory_order_relaxed); }
+
+    // 输出各阶段耗时与吞吐，并写出 JSON（path 为空时只输出日志）
+    void report(const string& jsonPath);
+
+    static const char* phaseName(BuildPhase phase);
+
+private:
+    BuildProfiler() = default;
+    BuildProfiler(const BuildProfiler&) = delete;
+    BuildProfiler& operator=(const BuildProfiler&) = delete;
+
+private:
+    std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+    std::atomic<int64_t> _phaseNs[PHASE_COUNT] = {};
+    std::atomic<uint64_t> _inputBytes{0};
+    std::atomic<uint64_t> _inputDocs{0};
+    size_t _indexedDocs = 0;
+    std::atomic<bool> _mappedInput{false};
+};
+
+// 作用域计时：析构（或 stop）时累加到对应构建阶段
+class PhaseTimer {
+public:
+    explicit PhaseTimer(BuildPhase phase)
+        : _phase(phase), _start(std::chrono::steady_clock::now()) {}
+    ~PhaseTimer() { stop(); }
+
+    void stop() {
+        if (!_stopped) {
+            _stopped = true;
+            BuildProfiler::getInstance()->add(_phase, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - _start).count());
+        }
+    }
+
+private:
+    BuildPhase _phase;
+    std::chrono::steady_clock::time_point _start;
+    bool _stopped = false;
+};
+
+#endif // __BUILD_PROFILER_H__
@@ -0,0 +1,60 @@
+#ifndef __CACHE_WARMER_H__
+#define __CACHE_WARMER_H__
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+using std::string;
+using std::vector;
+
+// 缓存预热器：热点 key 快照 + 查询日志 + 启动时并行回放
+class CacheWarmer {
+public:
+    CacheWarmer(const string& snapshotPath, const string& queryLogPath);
+    ~CacheWarmer();
+
+    // 记录一次查询（只写入内存缓冲，由 flushQueryLog 批量落盘）
+    // 缓冲按线程分片，各网络线程互不争用同一把锁；分片已满时丢弃并计数
+    void recordQuery(const string& query);
+
+    // 将缓冲中的查询追加到日志文件，超过上限时滚动；上次落盘以来丢弃的查询数记入日志
+    void flushQueryLog();
+
+    // 保存热点 key 快照（先写临时文件再 rename，保证原子替换）
+    void saveSnapshot(const vector<string>& hotKeys);
+
+    // 选出预热查询：快照中的热点 key 优先，再按查询日志中的频次补足
+    vector<string> loadWarmupQueries(size_t limit) const;
+
+    // 使用 threads 个后台线程回放查询
+    static void replay(const vector<string>& queries, int threads,
+                       const std::function<void(const string&)>& handler);
+
+private:
+    vector<string> loadSnapshot() const;
+    vector<string> topLoggedQueries(size_t limit) const;
+
+private:
+    static constexpr size_t MAX_LOG_BYTES = 64 * 1024 * 1024;  // 查询日志滚动阈值
+    static constexpr size_t MAX_PENDING = 100000;              // 内存缓冲上限（全部分片合计）
+    static constexpr size_t PENDING_SHARDS = 16;
+
+    // 独占缓存行，避免相邻分片的锁互相伪共享
+    struct alignas(64) PendingShard {
+        std::mutex mutex;
+        vector<string> queries;
+    };
+
+    string _snapshotPath;
+    string _queryLogPath;
+
+    std::array<PendingShard, PENDING_SHARDS> _pending;
+    std::atomic<uint64_t> _dropped{0};
+};
+
+#endif // __CACHE_WARMER_H__
@@ -14,6 +14,14 @@ public:
 
     void load(const string& configPath);
     string get(const string& key) const;
+    bool has(const string& key) const;
+    // 以下读取函数在未配置或值为空时返回 defaultValue；
+    // 值不是合法的数值 / 布尔值时抛出 std::invalid_argument，消息中带有配置项名
+    string get(const string& key, const string& defaultValue) const;
+    int getInt(const string& key, int defaultValue) const;
+    size_t getSize(const string& key, size_t defaultValue) const;
+    double getDouble(const string& key, double defaultValue) const;
+    bool getBool(const string& key, bool defaultValue) const;
 
 private:
     Configuration() = default;
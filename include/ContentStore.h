@@ -0,0 +1,72 @@
+#ifndef __CONTENT_STORE_H__
+#define __CONTENT_STORE_H__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "SnippetEngine.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+struct WebPageMeta;
+
+// 内容存储器：负责从磁盘读取正文
+// 默认将 .content 文件整体只读 mmap，读取正文只是返回映射内的视图，不再有 open/seek/read/close；
+// 文件超过 mmapLimit 或 mmap 失败时退化为共享同一个 fd 的 pread
+class ContentStore {
+public:
+    static constexpr size_t DEFAULT_MMAP_LIMIT = (size_t)16 << 30;  // 16GB
+
+    explicit ContentStore(const string& contentFilePath,
+                          size_t mmapLimit = DEFAULT_MMAP_LIMIT);
+    ~ContentStore();
+
+    ContentStore(const ContentStore&) = delete;
+    ContentStore& operator=(const ContentStore&) = delete;
+
+    // 根据偏移量读取内容
+    // mmap 模式返回映射内的视图（生命周期与 ContentStore 相同）；
+    // pread 模式读入 scratch 并返回其视图
+    string_view readContent(size_t offset, size_t length, string& scratch) const;
+
+    // 加载建库时生成的分句索引（.seg 文件，同样只读 mmap）
+    bool loadSegments(const string& segFilePath);
+
+    // 文档的句子结束偏移，未加载分句索引或越界时返回 nullptr
+    const uint32_t* segments(size_t segOffset, uint32_t segCount) const;
+
+    // 生成摘要（延迟读取版本，现场分句）
+    string getSummary(size_t offset, size_t length,
+                      const vector<string>& queryWords,
+                      size_t maxChars = 150) const;
+
+    // 生成摘要：使用元数据中的预计算分句选取最佳窗口
+    string getSummary(const WebPageMeta& meta,
+                      const vector<string>& queryWords,
+                      size_t maxChars = 150) const;
+
+    // 从已读取的正文片段生成摘要（供异步读取路径复用），ends 为空时现场分句
+    static string summarize(string_view text, const vector<string>& queryWords,
+                            const uint32_t* ends = nullptr, size_t count = 0,
+                            size_t maxChars = 150);
+
+    static constexpr size_t SUMMARY_READ_BYTES = SnippetEngine::SCAN_BYTES;  // 摘要最多读取的正文字节数
+
+    bool isMapped() const { return _data != nullptr; }
+    int fd() const { return _fd; }
+    size_t fileSize() const { return _fileSize; }
+
+private:
+    string _filePath;
+    int _fd = -1;
+    size_t _fileSize = 0;
+    const char* _data = nullptr;  // mmap 起始地址，pread 模式下为 nullptr
+
+    const uint32_t* _segData = nullptr;  // 分句索引映射
+    size_t _segCount = 0;                // 分句索引中的 uint32 个数
+};
+
+#endif // __CONTENT_STORE_H__
@@ -0,0 +1,70 @@
+#ifndef __CORPUS_GENERATOR_H__
+#define __CORPUS_GENERATOR_H__
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using std::string;
+using std::vector;
+
+// 合成语料参数
+struct CorpusOptions {
+    size_t docs = 100000;
+    size_t vocabSize = 50000;
+    double zipfExponent = 1.0;      // 词频 ∝ 1 / rank^s
+    double docLenMu = 5.5;          // 文档词数服从对数正态分布，中位数 e^mu（约 245 词）
+    double docLenSigma = 0.8;
+    size_t minDocWords = 20;
+    size_t maxDocWords = 5000;
+    double duplicateRate = 0.05;    // 近似重复文档占比
+    double duplicateEdits = 0.02;   // 近似重复文档中被替换的词占比
+    size_t queries = 100000;        // 查询日志行数
+    double queryExponent = 1.0;     // 查询热度 Zipf 指数
+    uint64_t seed = 42;
+    string vocabPath;               // 词表文件（每行第一列为词，按频率降序），为空时生成随机汉字词
+};
+
+// 合成语料生成器：输出与新闻语料相同格式的 <doc> XML 以及配套的查询日志
+// 随机数发生器与各分布均为自行实现，不依赖标准库分布的实现细节，相同参数与种子换编译器也能复现同一份语料
+class CorpusGenerator {
+public:
+    explicit CorpusGenerator(const CorpusOptions& options);
+
+    // 写出语料，返回文档数（含近似重复）
+    size_t writeCorpus(const string& path);
+
+    // 写出查询日志（每行一个查询，与 CacheWarmer 查询日志格式相同），返回行数
+    size_t writeQueryLog(const string& path);
+
+    size_t vocabSize() const { return _vocab.size(); }
+
+private:
+    // xoshiro256** 发生器
+    uint64_t next();
+    double uniform();               // [0, 1)
+    double normal();                // 标准正态（Box-Muller）
+
+    void loadVocabulary(const string& path);
+    void generateVocabulary();
+
+    // Vose 别名表：O(1) 按给定权重抽样
+    struct AliasTable {
+        vector<double> prob;
+        vector<uint32_t> alias;
+    };
+    static AliasTable buildAlias(const vector<double>& weights);
+    size_t sample(const AliasTable& table);
+    static vector<double> zipfWeights(size_t n, double exponent);
+
+    size_t docWordCount();
+    void appendText(string& out, const vector<uint32_t>& words, bool title);
+
+private:
+    CorpusOptions _options;
+    uint64_t _state[4];
+    vector<string> _vocab;
+    AliasTable _wordTable;
+};
+
+#endif // __CORPUS_GENERATOR_H__
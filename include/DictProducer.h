@@ -42,6 +42,9 @@ public:
     // 根据字符获取候选词
     vector<string> getCandidates(const string& prefix) const;
 
+    // 词典与字符索引的内存占用估算（字节）
+    size_t memoryUsage() const;
+
 private:
     // 构建字符索引
     void buildIndex();
@@ -6,6 +6,7 @@
 #include <map>
 #include <unordered_map> // 优化: 引入哈希表
 #include <memory>
+#include <cstdint>
 
 using std::string;
 using std::vector;
@@ -15,6 +16,8 @@ using std::pair;
 using std::shared_ptr;
 
 class WebPage;
+class HotTermCache;
+struct HotTermEntry;
 
 // 倒排索引项：文档ID + 权重
 // 优化: 保持 POD 结构，内存布局紧凑
@@ -25,27 +28,103 @@ struct InvertIndexItem {
     int termFreq;   // 词频该词出现在该文档的次数（词频）
 };
 
+// 单次检索的执行统计（/search?explain=1 与慢查询日志使用）
+// 检索时只记录几个计数器，各查询词的倒排表概况由 describeTerms 在需要输出时补全
+struct SearchStats {
+    struct TermStats {
+        string term;
+        int count = 0;              // 在查询中出现的次数
+        size_t postings = 0;        // 倒排表长度
+        double maxImpact = 0;       // 倒排表中的最大权重
+        bool hot = false;           // 命中热词缓存
+    };
+    vector<TermStats> terms;
+    string path;                    // "threshold" 或 "exhaustive"
+    bool fallback = false;          // 阈值算法预判或实际无法提前终止（直接完整遍历或补全热词倒排表）
+    size_t postingsScored = 0;      // 读取的倒排项数（含随机访问）
+    size_t docsTouched = 0;         // 计算过得分的文档数
+    uint64_t hotTermMask = 0;       // 按规范顺序（去重后字典序）第 i 个查询词命中热词缓存，只记录前 64 个
+};
+
+// 一批查询共用的词项解析结果：每个词只查一次倒排表与热词缓存（批量搜索使用）
+struct ResolvedTerms {
+    struct Term {
+        const vector<InvertIndexItem>* postings = nullptr;  // 不在索引中时为空
+        shared_ptr<const HotTermEntry> hot;                // 不是热词时为空
+    };
+    unordered_map<string, Term> terms;
+};
+
 class InvertIndex {
 public:
     InvertIndex();
+    ~InvertIndex();
     //为计算BM25做准备
     void build(vector<shared_ptr<WebPage>>& pages);
 
     //  增根据查询词搜索权重最大的前20个
-    vector<pair<int, double>> search(const vector<string>& queryWords, int topK = 20);
+    // stats 不为空时记录执行统计；admit 为 false 时不改变热词缓存状态（只读已缓存的条目，供诊断请求使用）
+    vector<pair<int, double>> search(const vector<string>& queryWords, int topK = 20,
+                                     SearchStats* stats = nullptr, bool admit = true);
+
+    // 批量检索：先用 resolveTerms 解析整批查询涉及的全部词，各查询检索时共享这些查找结果。
+    // 热词缓存对整批每个词只计频一次；结果与逐条 search 完全相同，可在多个线程上并发调用
+    ResolvedTerms resolveTerms(const vector<vector<string>>& queries);
+    vector<pair<int, double>> search(const vector<string>& queryWords, int topK, const ResolvedTerms& resolved);
+
+    // 按首次出现顺序填充 stats.terms（倒排表长度、最大权重、是否命中热词缓存）
+    void describeTerms(const vector<string>& queryWords, SearchStats& stats) const;
+
+    // 游标翻页：返回排在 (afterScore, afterDocId) 之后的前 topK 个，堆大小只与页大小有关
+    vector<pair<int, double>> searchAfter(const vector<string>& queryWords, int topK,
+                                          double afterScore, int afterDocId);
+
+    // 结果排序规则：得分降序，同分按 docId 升序，保证翻页顺序确定
+    static bool rankBefore(const pair<int, double>& a, const pair<int, double>& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    }
     //存储 和 加载 网页
     void store(const string& filePath);
     void load(const string& filePath);
 
     int getTotalDocs() const { return _totalDocs; }
 
+    // 内存占用估算（字节）：倒排表（含词项）与文档长度表
+    size_t postingsMemory() const;
+    size_t docLensMemory() const;
+
+    // 启用热词倒排缓存（词级前缀 + 词对交集），termCapacity 为 0 时不启用
+    void enableTermCache(size_t termCapacity, size_t pairCapacity,
+                         uint32_t admitThreshold, size_t prefixLen, size_t minPostings);
+    HotTermCache* getTermCache() const { return _termCache.get(); }
+
 private:
     static constexpr double K1 = 1.2;
     static constexpr double B = 0.75;
+    // 一次热词随机访问（二分查找）相当于顺序累加一个倒排项的代价倍数，用于阈值算法的预判与预算
+    static constexpr size_t RANDOM_ACCESS_COST = 32;
 
     double calculateIDF(int docFreq, int totalDocs);
     double calculateBM25(int termFreq, int docLen, int docFreq);
 
+    // 规范累加顺序：查询词去重后按字典序，每个词累加一次 weight * 出现次数。
+    // 所有检索路径都按此顺序求和，同一文档的得分逐位相同，游标（精确得分 + docId）才能跨路径衔接
+    static map<string, int> countTerms(const vector<string>& queryWords);
+
+    // 词的倒排表：resolved 不为空时取预先解析的结果，否则查索引；不存在返回 nullptr
+    const vector<InvertIndexItem>* findPostings(const string& word, const ResolvedTerms* resolved) const;
+
+    // 完整遍历所有倒排表累加得分；after 不为空时只保留排在其后的文档
+    vector<pair<int, double>> searchExhaustive(const vector<string>& queryWords, int topK,
+                                               const pair<int, double>* after = nullptr,
+                                               SearchStats* stats = nullptr,
+                                               const ResolvedTerms* resolved = nullptr);
+    // 基于热词前缀的阈值算法（Fagin TA）；查询中没有热词或预判代价高于完整遍历时返回 false，
+    // 运行中超出随机访问预算时在已有打分的基础上补全；batchTerms 不为空时热词条目取自其中
+    bool searchWithTermCache(const vector<string>& queryWords, int topK,
+                             vector<pair<int, double>>& results, SearchStats* stats, bool admit,
+                             const ResolvedTerms* batchTerms = nullptr);
+
 private:
     // 优化: 使用 unordered_map 替代 map，查询速度提升至 O(1)
     unordered_map<string, vector<InvertIndexItem>> _invertIndex;
@@ -53,6 +132,8 @@ private:
     map<int, int> _docLens; //每个文档（存储ID）对应的长度
     int _totalDocs;//总的文件数
     double _avgDocLen;//平均文件长度
+
+    std::unique_ptr<HotTermCache> _termCache; // 热词倒排缓存（可选）
 };
 
 #endif // __INVERT_INDEX_H__
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef __JSON_WRITER_H__
+#define __JSON_WRITER_H__
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+using std::string;
+using std::string_view;
+
+// 流式 JSON 写入器：直接把转义后的内容追加到输出缓冲，不构建 DOM
+// 字符串值在转义的同时校验 UTF-8，非法字节直接丢弃（替代原先的 cleanUtf8 预处理）
+class JsonWriter {
+public:
+    explicit JsonWriter(string& out) : _out(out) {}
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+
+    JsonWriter& key(string_view name);
+
+    JsonWriter& value(string_view s);
+    JsonWriter& value(const char* s) { return value(string_view(s)); }
+    JsonWriter& value(const string& s) { return value(string_view(s)); }
+    JsonWriter& value(int64_t v);
+    JsonWriter& value(int v) { return value((int64_t)v); }
+    JsonWriter& value(size_t v);
+    JsonWriter& value(double v);
+    JsonWriter& value(bool v);
+
+    // 追加已是合法 JSON 的片段（调用方保证已转义）
+    JsonWriter& raw(string_view json);
+
+    // 追加已转义的字符串值：只补引号，内容原样拷贝
+    JsonWriter& escapedValue(string_view escaped);
+
+    // 追加 JSON 转义后的字符串内容（不含引号），非法 UTF-8 字节被丢弃
+    static void escape(string& out, string_view s);
+
+private:
+    // 在同一层级的第二个及之后的元素前写逗号
+    void separator();
+
+private:
+    string& _out;
+    uint64_t _hasElement = 0;  // 每一位表示对应嵌套层是否已有元素
+    int _depth = 0;
+    bool _afterKey = false;
+};
+
+#endif // __JSON_WRITER_H__
@@ -8,6 +8,11 @@
 #include <array>
 #include <atomic>
 #include <functional>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include "MemoryUsage.h"
 
 using std::list;
 using std::unordered_map;
@@ -16,6 +21,13 @@ using std::pair;
 using std::mutex;
 using std::lock_guard;
 
+// 单个分片的统计（用于 /metrics）
+struct CacheShardStats {
+    size_t size;
+    uint64_t hits;
+    uint64_t misses;
+};
+
 // 单个 LRU 分片
 template<typename K, typename V>
 class LRUShard {
@@ -28,13 +40,26 @@ public:
         lock_guard<mutex> lock(_mutex);
         auto it = _index.find(key);
         if (it == _index.end()) {
+            _misses.fetch_add(1, std::memory_order_relaxed);
             return false;
         }
+        _hits.fetch_add(1, std::memory_order_relaxed);
         _cache.splice(_cache.begin(), _cache, it->second);
         value = it->second->second;
         return true;
     }
 
+    // 只读查找：不调整 LRU 顺序，也不计入命中统计
+    bool peek(const K& key, V& value) {
+        lock_guard<mutex> lock(_mutex);
+        auto it = _index.find(key);
+        if (it == _index.end()) {
+            return false;
+        }
+        value = it->second->second;
+        return true;
+    }
+
     void put(const K& key, const V& value) {
         lock_guard<mutex> lock(_mutex);
         auto it = _index.find(key);
@@ -68,11 +93,41 @@ public:
         _index.clear();
     }
 
+    // 按最近使用顺序导出前 limit 个 key（用于缓存快照）
+    std::vector<K> keys(size_t limit) {
+        lock_guard<mutex> lock(_mutex);
+        std::vector<K> result;
+        result.reserve(std::min(limit, _cache.size()));
+        for (auto it = _cache.begin(); it != _cache.end() && result.size() < limit; ++it) {
+            result.push_back(it->first);
+        }
+        return result;
+    }
+
+    CacheShardStats stats() {
+        size_t entries = size();
+        return {entries, _hits.load(std::memory_order_relaxed), _misses.load(std::memory_order_relaxed)};
+    }
+
+    // 本分片的堆内存估算：链表节点、索引哈希表、key（两份）以及 valueBytes 给出的值占用
+    template<typename Sizer>
+    size_t memoryUsage(Sizer valueBytes) {
+        lock_guard<mutex> lock(_mutex);
+        size_t bytes = _cache.size() * mallocBytes(2 * sizeof(void*) + sizeof(pair<K, V>))
+            + hashTableBytes(_index);
+        for (const auto& entry : _cache) {
+            bytes += 2 * heapBytes(entry.first) + valueBytes(entry.second);
+        }
+        return bytes;
+    }
+
 private:
     size_t _capacity;
     list<pair<K, V>> _cache;
     unordered_map<K, typename list<pair<K, V>>::iterator> _index;
     mutex _mutex;
+    std::atomic<uint64_t> _hits{0};
+    std::atomic<uint64_t> _misses{0};
 };
 
 // 分段锁 LRU 缓存
@@ -91,6 +146,11 @@ public:
         return getShard(key).get(key, value);
     }
 
+    // 只读查找（诊断接口使用）：不调整 LRU 顺序，不计入命中统计
+    bool peek(const K& key, V& value) {
+        return getShard(key).peek(key, value);
+    }
+
     void put(const K& key, const V& value) {
         getShard(key).put(key, value);
     }
@@ -113,12 +173,61 @@ public:
         }
     }
 
+    // 导出最热的 limit 个 key：各分片按 LRU 顺序轮流取，近似全局热度排序
+    std::vector<K> hottestKeys(size_t limit) {
+        std::array<std::vector<K>, ShardCount> perShard;
+        for (size_t i = 0; i < ShardCount; ++i) {
+            perShard[i] = _shards[i]->keys(limit);
+        }
+        std::vector<K> result;
+        for (size_t rank = 0; result.size() < limit; ++rank) {
+            bool any = false;
+            for (size_t i = 0; i < ShardCount && result.size() < limit; ++i) {
+                if (rank < perShard[i].size()) {
+                    result.push_back(perShard[i][rank]);
+                    any = true;
+                }
+            }
+            if (!any) break;
+        }
+        return result;
+    }
+
+    // 各分片的条目数与命中统计，用于观察分片是否倾斜
+    std::vector<CacheShardStats> shardStats() {
+        std::vector<CacheShardStats> result;
+        result.reserve(ShardCount);
+        for (size_t i = 0; i < ShardCount; ++i) {
+            result.push_back(_shards[i]->stats());
+        }
+        return result;
+    }
+
+    // 整个缓存的堆内存估算（逐分片加锁遍历，只用于统计接口）
+    template<typename Sizer>
+    size_t memoryUsage(Sizer valueBytes) {
+        size_t bytes = 0;
+        for (size_t i = 0; i < ShardCount; ++i) {
+            bytes += mallocBytes(sizeof(LRUShard<K, V>)) + _shards[i]->memoryUsage(valueBytes);
+        }
+        return bytes;
+    }
+
+    // 值为字符串的缓存
+    size_t memoryUsage() {
+        return memoryUsage([](const V& value) { return heapBytes(value); });
+    }
+
     double hitRate() const {
         size_t total = _totalQueries.load();
         if (total == 0) return 0;
         return (double)_hits.load() / total;
     }
 
+    // 累计命中数与查询数，压测工具据此求区间命中率
+    size_t hits() const { return _hits.load(); }
+    size_t lookups() const { return _totalQueries.load(); }
+
     void recordQuery(bool hit) {
         _totalQueries.fetch_add(1, std::memory_order_relaxed);
         if (hit) {
@@ -144,4 +253,7 @@ using SearchLRUCache = ShardedLRUCache<K, V, 16>;
 
 using SearchCache = SearchLRUCache<string, string>;
 
+// 摘要缓存：key 为 docId + 归一化查询词集合，跨查询共享
+using SnippetCache = ShardedLRUCache<string, string, 32>;
+
 #endif
@@ -0,0 +1,90 @@
+#ifndef __LOAD_GENERATOR_H__
+#define __LOAD_GENERATOR_H__
+
+#include "Metrics.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+using std::string;
+using std::vector;
+using std::map;
+
+// 压测参数
+struct LoadOptions {
+    string host = "127.0.0.1";
+    int port = 8080;
+    string path = "/search";        // 查询以 ?q= 附加在后面
+    double rate = 0;                // 目标到达率（请求/秒），泊松到达；0 表示闭环，并发槽一空就发
+    int concurrency = 64;           // 同时在途请求上限
+    size_t requests = 0;            // 发送总数，0 表示把查询日志回放一遍
+    double durationSec = 0;         // 最长发送时间，0 表示不限
+    int timeoutMs = 5000;
+    uint64_t seed = 42;
+};
+
+// 压测结果；延迟从计划到达时刻算起，并发槽满时的客户端排队也计入，避免协同遗漏
+struct LoadReport {
+    size_t sent = 0;
+    size_t completed = 0;           // 2xx
+    size_t rejected = 0;            // 503（准入控制拒绝）
+    size_t failed = 0;              // 其他状态码、超时与连接错误
+    map<int, size_t> statusCounts;  // 0 表示网络层失败
+    double elapsedSec = 0;
+    double targetRate = 0;
+    double achievedQps = 0;         // 成功请求数 / 耗时
+    HistogramSnapshot latency;      // 计划到达 -> 收到响应
+    HistogramSnapshot service;      // 实际发出 -> 收到响应
+    uint64_t maxLatencyUs = 0;
+
+    // 压测期间服务端结果缓存命中率（由压测前后 /health 的命中计数求差）
+    bool haveCacheStats = false;
+    double cacheHitRate = 0;
+    uint64_t cacheLookups = 0;
+
+    void log() const;
+    void toJson(string& out) const;
+};
+
+// 查询日志回放压测：开环到达 + 并发上限，通过 HTTP 打到运行中的服务
+class LoadGenerator {
+public:
+    explicit LoadGenerator(const LoadOptions& options);
+
+    // 读取查询日志（每行一个查询，与 CacheWarmer 查询日志格式相同），返回条数
+    size_t loadQueries(const string& path);
+
+    LoadReport run();
+
+private:
+    struct Request;
+    void issue(size_t index, std::chrono::steady_clock::time_point scheduled);
+    void onResponse(Request* request, int status);
+
+    // 同步 GET，返回响应体；失败返回空串
+    string fetch(const string& path);
+    bool fetchCacheCounters(uint64_t& hits, uint64_t& lookups);
+
+    string baseUrl() const;
+    static string urlEncode(const string& raw);
+
+private:
+    LoadOptions _options;
+    vector<string> _queries;
+
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    int _inflight = 0;
+
+    LatencyHistogram _latency;
+    LatencyHistogram _service;
+    std::atomic<uint64_t> _maxLatencyUs{0};
+    map<int, size_t> _statusCounts;     // 受 _mutex 保护
+};
+
+#endif // __LOAD_GENERATOR_H__
@@ -2,25 +2,50 @@
 #define __LOGGER_H__
 
 #include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
 #include <log4cpp/Category.hh>
+#include <log4cpp/Priority.hh>
 #include <log4cpp/PropertyConfigurator.hh>
 
 using std::string;
+using std::vector;
 
 // 日志管理器：单例模式封装 log4cpp
+// 异步写出：各线程把日志放入自己的环形缓冲（单生产者单消费者，无锁），
+// 由后台写线程按时间顺序汇总后交给 log4cpp 的 appender。写日志的线程从不做文件 I/O：
+// 缓冲写满时唤醒写线程并短暂等待，仍无空位则丢弃该条并计数，丢弃数由写线程补记一条 WARN
 class Logger {
 public:
     static Logger* getInstance();
 
-    // 初始化日志系统（从配置文件加载）
+    // 初始化日志系统（从配置文件加载）并启动后台写线程，进程退出时自动写出剩余日志
     void init(const string& configPath = "conf/log4cpp.properties");
 
+    // 级别判断：宏在构造消息之前调用，未启用的级别不产生任何字符串拼接
+    bool isEnabled(int priority) const {
+        return priority <= _level.load(std::memory_order_relaxed);
+    }
+
     // 日志输出接口
     void debug(const string& msg);
     void info(const string& msg);
     void warn(const string& msg);
     void error(const string& msg);
-    void fatal(const string& msg);
+    void fatal(const string& msg);   // 提交后立即同步写出全部缓冲
+
+    // 同步写出所有线程缓冲中的日志
+    void flush();
+
+    // 因缓冲写满累计丢弃的日志条数
+    uint64_t droppedCount() const { return _droppedTotal.load(std::memory_order_relaxed); }
+
+    // 停止后台写线程并写出剩余日志
+    void shutdown();
 
     // 获取底层 Category（高级用法）
     log4cpp::Category& getCategory() { return *_category; }
@@ -31,17 +56,55 @@ private:
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
 
+    struct ThreadBuffer;
+    ThreadBuffer& local();
+
+    void log(int priority, const string& msg);
+    void append(int priority, int64_t timeUs, const string& msg);
+    void drain();
+    void drainLocked();                           // 调用方持有 _drainMutex
+    void writerLoop();
+
 private:
     static Logger* _pInstance;
     log4cpp::Category* _category;
     bool _initialized;
+    std::atomic<int> _level;
+
+    std::mutex _registryMutex;                    // 只在线程首次写日志和写线程汇总时加锁
+    vector<std::shared_ptr<ThreadBuffer>> _registry;
+
+    std::mutex _drainMutex;                       // 同一时刻只有一个消费者；同步写出也持有它，与汇总互斥
+    std::mutex _appendMutex;                      // 串行化对 appender 的调用
+
+    std::mutex _wakeMutex;
+    std::condition_variable _wakeCv;
+    bool _stopping = false;
+    std::atomic<bool> _async{false};              // 写线程运行中，日志走缓冲
+    std::atomic<int> _producers{0};               // 正在写入缓冲的线程数，shutdown 等它归零后才做最后一次汇总
+    std::thread _writer;
+
+    static constexpr int FULL_WAIT_US = 2000;     // 缓冲写满时等待写线程腾出空位的上限
+    std::atomic<uint64_t> _dropped{0};            // 尚未补记到日志中的丢弃数
+    std::atomic<uint64_t> _droppedTotal{0};
 };
 
-// 便捷宏定义：简化日志调用
-#define LOG_DEBUG(msg) Logger::getInstance()->debug(msg)
-#define LOG_INFO(msg)  Logger::getInstance()->info(msg)
-#define LOG_WARN(msg)  Logger::getInstance()->warn(msg)
-#define LOG_ERROR(msg) Logger::getInstance()->error(msg)
-#define LOG_FATAL(msg) Logger::getInstance()->fatal(msg)
+// 便捷宏定义：先判断级别再构造消息
+// 定义 LOG_STRIP_DEBUG 编译时去掉全部 DEBUG 日志（参数不会被求值）
+#define LOG_AT(priority, method, msg)                         \
+    do {                                                      \
+        Logger* logger_ = Logger::getInstance();              \
+        if (logger_->isEnabled(priority)) logger_->method(msg); \
+    } while (0)
+
+#ifdef LOG_STRIP_DEBUG
+#define LOG_DEBUG(msg) do {} while (0)
+#else
+#define LOG_DEBUG(msg) LOG_AT(log4cpp::Priority::DEBUG, debug, msg)
+#endif
+#define LOG_INFO(msg)  LOG_AT(log4cpp::Priority::INFO, info, msg)
+#define LOG_WARN(msg)  LOG_AT(log4cpp::Priority::WARN, warn, msg)
+#define LOG_ERROR(msg) LOG_AT(log4cpp::Priority::ERROR, error, msg)
+#define LOG_FATAL(msg) LOG_AT(log4cpp::Priority::FATAL, fatal, msg)
 
 #endif // __LOGGER_H__
@@ -0,0 +1,54 @@
+#ifndef __MEMORY_USAGE_H__
+#define __MEMORY_USAGE_H__
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <cstddef>
+
+using std::string;
+using std::vector;
+
+// 各数据结构的内存占用估算，按 glibc malloc 的实际块大小计（8 字节块头、16 字节对齐、最小 32 字节）
+// 只统计堆上的部分，对象本身所在的内存由持有者计入
+
+inline size_t mallocBytes(size_t n) {
+    return n == 0 ? 0 : std::max((n + 8 + 15) & ~(size_t)15, (size_t)32);
+}
+
+// 短字符串（libstdc++ 为 15 字节以内）存放在对象内部，不占堆
+inline size_t heapBytes(const string& s) {
+    return s.capacity() > 15 ? mallocBytes(s.capacity() + 1) : 0;
+}
+
+template<typename T>
+size_t vectorHeapBytes(const vector<T>& v) {
+    return mallocBytes(v.capacity() * sizeof(T));
+}
+
+// map / set 的单个红黑树节点：颜色 + 3 个指针 + 元素
+template<typename Value>
+size_t treeNodeBytes() {
+    return mallocBytes(4 * sizeof(void*) + sizeof(Value));
+}
+
+// 哈希表：桶数组 + 节点（next 指针 + 元素，非整数 key 额外缓存哈希值）
+template<typename HashMap>
+size_t hashTableBytes(const HashMap& m) {
+    size_t node = sizeof(void*) + sizeof(typename HashMap::value_type)
+        + (std::is_integral<typename HashMap::key_type>::value ? 0 : sizeof(size_t));
+    return m.size() * mallocBytes(node) + mallocBytes(m.bucket_count() * sizeof(void*));
+}
+
+// 进程级内存（来自分配器与内核），用于核对各组件估算之和
+struct ProcessMemory {
+    size_t residentBytes = 0;   // RSS
+    size_t heapInUse = 0;       // 已分配出去的堆内存（含 mmap 分配的大块）
+    size_t heapFree = 0;        // 分配器持有但空闲的内存
+    size_t heapMapped = 0;      // 其中以 mmap 单独分配的大块
+};
+
+ProcessMemory processMemory();
+
+#endif // __MEMORY_USAGE_H__
@@ -0,0 +1,134 @@
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+using std::string;
+using std::vector;
+
+// 请求处理阶段
+enum Stage {
+    STAGE_URL_DECODE = 0,
+    STAGE_TOKENIZE,
+    STAGE_CACHE_LOOKUP,
+    STAGE_RETRIEVAL,
+    STAGE_SNIPPET,
+    STAGE_SERIALIZE,
+    STAGE_SUGGEST,
+    STAGE_REQUEST,      // 搜索请求端到端耗时
+    STAGE_COUNT
+};
+
+// 接口
+enum Endpoint {
+    ENDPOINT_SEARCH = 0,
+    ENDPOINT_MSEARCH,
+    ENDPOINT_SUGGEST,
+    ENDPOINT_COUNT
+};
+
+// 对数线性分桶的延迟直方图（HDR 风格）：每个 2 的幂区间再均分 16 个子桶，相对误差约 6%
+// 覆盖 1us ~ 2^32us，只有所属线程写入，读取方直接汇总各线程的原子计数，无需加锁
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 4;
+    static constexpr int SUB_COUNT = 1 << SUB_BITS;
+    static constexpr int BUCKET_COUNT = (32 - SUB_BITS + 1) * SUB_COUNT;
+
+    void record(int64_t us);
+
+    // 桶下标与桶上界（微秒，不含）
+    static int bucketOf(uint64_t us);
+    static uint64_t bucketUpper(int bucket);
+
+    std::atomic<uint64_t> counts[BUCKET_COUNT] = {};
+    std::atomic<uint64_t> sumUs{0};
+};
+
+// 多个线程直方图合并后的快照
+struct HistogramSnapshot {
+    vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t sumUs = 0;
+
+    // 分位数（微秒），取所在桶的上界
+    uint64_t quantile(double q) const;
+};
+
+// 全局指标：各阶段延迟直方图（线程私有）、请求与错误计数、QPS
+class Metrics {
+public:
+    static Metrics* getInstance();
+
+    // 记录一次阶段耗时（写入当前线程的直方图）
+    void record(Stage stage, int64_t us);
+
+    void countRequest(Endpoint endpoint);
+    void countError(int status);
+
+    // 汇总所有线程的直方图
+    HistogramSnapshot snapshot(Stage stage) const;
+
+    // 最近 windowSec 秒（不含当前秒）的平均 QPS
+    double qps(Endpoint endpoint, int windowSec = 10) const;
+
+    // 以 Prometheus 文本格式输出本类维护的指标
+    void render(string& out) const;
+
+    // Prometheus 文本格式辅助
+    static void appendHeader(string& out, const char* name, const char* type, const char* help);
+    static void appendSample(string& out, const char* name, const string& labels, double value);
+
+    static const char* stageName(Stage stage);
+    static const char* endpointName(Endpoint endpoint);
+
+private:
+    Metrics() = default;
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    struct ThreadHistograms {
+        LatencyHistogram stages[STAGE_COUNT];
+    };
+    ThreadHistograms& local();
+
+    // 按秒计数的环形窗口
+    struct RateSlot {
+        std::atomic<int64_t> second{-1};
+        std::atomic<uint64_t> count{0};
+    };
+    static constexpr int RATE_SLOTS = 64;
+
+private:
+    mutable std::mutex _registryMutex;  // 只在线程首次记录和导出时加锁
+    vector<std::shared_ptr<ThreadHistograms>> _registry;
+
+    std::atomic<uint64_t> _requests[ENDPOINT_COUNT] = {};
+    std::atomic<uint64_t> _clientErrors{0};
+    std::atomic<uint64_t> _serverErrors{0};
+    RateSlot _rates[ENDPOINT_COUNT][RATE_SLOTS];
+};
+
+// 作用域计时：析构（或 stop）时记录到对应阶段直方图
+class StageTimer {
+public:
+    explicit StageTimer(Stage stage)
+        : _stage(stage), _start(std::chrono::steady_clock::now()) {}
+    ~StageTimer() { stop(); }
+
+    // 记录并返回耗时（微秒），只记录一次
+    int64_t stop();
+
+private:
+    Stage _stage;
+    std::chrono::steady_clock::time_point _start;
+    bool _stopped = false;
+};
+
+#endif // __METRICS_H__
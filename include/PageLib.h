@@ -2,12 +2,14 @@
 #define __PAGE_LIB_H__
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <unordered_map>
 #include "WebPageMeta.h"
 
 using std::string;
+using std::string_view;
 using std::vector;
 using std::shared_ptr;
 using std::unordered_map;
@@ -30,16 +32,20 @@ public:
     void store(const string& outputPath);
 
     // === 新增：轻量级存储方案 ===
-    // 分离存储：元数据文件 + 内容文件
-    void storeSeparated(const string& metaPath, const string& contentPath);
+    // 分离存储：元数据文件 + 内容文件 (+ 分句索引文件，可选)
+    void storeSeparated(const string& metaPath, const string& contentPath,
+                        const string& segPath = "");
 
     // 加载轻量级元数据（不加载正文内容）
     static unordered_map<int, WebPageMeta> loadMeta(const string& metaPath);
 
 private:
-    // 解析单个文件
+    // 解析单个文件（mmap 映射后交给 parseBuffer）
     void parseFile(const string& filePath);
 
+    // 切分 <doc>...</doc> 块并逐个构造 WebPage；没有 <doc> 块时整个缓冲区作为一篇文档
+    void parseBuffer(string_view data);
+
 private:
     string _dataPath;
     SplitTool* _splitTool;
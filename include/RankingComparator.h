@@ -0,0 +1,68 @@
+#ifndef __RANKING_COMPARATOR_H__
+#define __RANKING_COMPARATOR_H__
+
+#include "Metrics.h"
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+using std::string;
+using std::vector;
+using std::pair;
+
+class InvertIndex;
+
+// 单个查询在两个引擎上的差异
+struct QueryDiff {
+    string query;
+    double overlap = 0;         // |topK(A) ∩ topK(B)| / |topK(A)|
+    double ndcg = 0;            // 以 A 的排名为标准答案时 B 的 NDCG@K
+    double maxScoreDelta = 0;   // 共同文档的最大得分差（绝对值）
+    bool identical = false;     // 文档与顺序完全一致
+};
+
+// 对比结果：A 为基准引擎，B 为被检查的引擎
+struct ComparisonReport {
+    string labelA;
+    string labelB;
+    int topK = 0;
+    size_t queries = 0;
+    size_t identical = 0;
+    size_t emptyBoth = 0;           // 两边都没有结果的查询
+    double meanOverlap = 0;
+    double minOverlap = 1;
+    double meanNdcg = 0;
+    double minNdcg = 1;
+    double meanScoreDelta = 0;      // 各查询最大得分差的均值
+    double maxScoreDelta = 0;
+    HistogramSnapshot latencyA;
+    HistogramSnapshot latencyB;
+    double speedup = 0;             // A 总耗时 / B 总耗时，大于 1 表示 B 更快
+    vector<QueryDiff> worst;        // 差异最大的若干查询（按 NDCG 升序）
+
+    void log() const;
+    void toJson(string& out) const;
+};
+
+// 排序回归对比：同一组查询分别在两个引擎上执行 InvertIndex::search，比较前 K 个结果与耗时
+// 两个引擎可以是两份不同格式 / 版本的索引，也可以是同一份索引开 / 关热词缓存
+class RankingComparator {
+public:
+    RankingComparator(InvertIndex* a, const string& labelA, InvertIndex* b, const string& labelB);
+
+    // queries 与 tokenized 一一对应（原始查询只用于报告）；warmupRounds 轮预热不计入结果，让热词缓存完成准入
+    ComparisonReport compare(const vector<string>& queries, const vector<vector<string>>& tokenized,
+                             int topK = 20, int warmupRounds = 1, size_t worstCount = 10);
+
+    // 单个查询的差异（按 InvertIndex::rankBefore 排好序的结果列表）
+    static QueryDiff diff(const vector<pair<int, double>>& a, const vector<pair<int, double>>& b);
+
+private:
+    InvertIndex* _a;
+    InvertIndex* _b;
+    string _labelA;
+    string _labelB;
+};
+
+#endif // __RANKING_COMPARATOR_H__
@@ -9,6 +9,8 @@
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <thread>
+#include <functional>
 #include "LRUCache.h"
 #include "WebPageMeta.h"
 
@@ -24,20 +26,72 @@ class SplitTool;
 class WebPage;
 class DictProducer;
 class KeywordRecommender;
+class CacheWarmer;
+class AdmissionController;
+class SlowQueryLog;
+class SeriesWork;
+struct SearchContext;
+struct BatchContext;
+
+namespace wfrest {
+class HttpResp;
+}
+
+// 响应字段：fields= 参数选择输出哪些字段，未选择的字段不读取、不计算
+enum ResponseField : unsigned {
+    FIELD_ID      = 1u << 0,
+    FIELD_SCORE   = 1u << 1,
+    FIELD_TITLE   = 1u << 2,
+    FIELD_URL     = 1u << 3,
+    FIELD_SUMMARY = 1u << 4,
+    FIELD_ALL     = FIELD_ID | FIELD_SCORE | FIELD_TITLE | FIELD_URL | FIELD_SUMMARY
+};
+
+// 翻页参数：from/size 偏移翻页，或以游标（上一页最后一条的得分与 docId）续翻
+struct SearchPage {
+    static constexpr int DEFAULT_SIZE = 20;
+    static constexpr int MAX_SIZE = 100;
+    static constexpr int MAX_WINDOW = 1000;   // from + size 上限
+
+    int from = 0;
+    int size = DEFAULT_SIZE;
+    bool hasCursor = false;
+    double afterScore = 0;
+    int afterDocId = 0;
+
+    // 首页默认大小：结果可整体缓存为响应
+    bool isFirstPage() const { return from == 0 && size == DEFAULT_SIZE && !hasCursor; }
+};
+
+// 缓存的深层排序列表：翻页请求在其深度内直接切片
+struct RankedList {
+    vector<pair<int, double>> items;
+    bool exhausted = false;                   // 已包含全部命中文档
+};
+using RankedListCache = ShardedLRUCache<string, shared_ptr<const RankedList>, 16>;
 
 // 搜索服务器：基于 wfrest 的 HTTP 服务
 class SearchServer {
 public:
+    // 配置 workflow 线程数（计算线程 / 网络 poller / handler），须在创建任何服务或任务之前调用
+    // 传入 0 表示沿用 workflow 默认值
+    static void configureThreads(int computeThreads, int pollerThreads, int handlerThreads);
+
     SearchServer(const string& ip, int port,
                  shared_ptr<InvertIndex> index,
                  SplitTool* splitTool);
+    ~SearchServer();
 
     // 设置网页库引用（用于获取标题、摘要等）- 传统模式
     void setPageLib(const map<int, shared_ptr<WebPage>>& pageLib);
 
     // 设置轻量级网页库（内存优化模式）
+    // 正文文件不超过 mmapLimit 字节时整体 mmap，否则使用 pread；
+    // segFilePath 为建库生成的分句索引，不存在时摘要现场分句
     void setPageLibLite(const unordered_map<int, WebPageMeta>& pageMeta,
-                        const string& contentFilePath);
+                        const string& contentFilePath,
+                        size_t mmapLimit = ContentStore::DEFAULT_MMAP_LIMIT,
+                        const string& segFilePath = "");
 
     // 设置词典和推荐器（可选）
     void setDictProducer(shared_ptr<DictProducer> dictProducer);
@@ -46,6 +100,34 @@ public:
     // 设置缓存大小
     void setCacheCapacity(size_t capacity);
 
+    // 设置排序列表缓存：翻页请求一次取 depth 条排序结果缓存，后续页直接切片（capacity 为 0 表示不启用）
+    void setRankedListCache(size_t capacity, int depth);
+
+    // 设置摘要缓存大小（0 表示不启用）
+    void setSnippetCacheCapacity(size_t capacity);
+
+    // 轻量模式下摘要读取改为 workflow 异步 pread 并发执行
+    // deadlineMs 内未完成的结果降级为仅返回标题
+    void setAsyncSnippet(bool enabled, int deadlineMs);
+
+    // 启用缓存快照与启动预热
+    // snapshotInterval 秒保存一次热点 key 快照并刷新查询日志；
+    // 启动后用 warmupThreads 个线程回放 warmupQueries 条热点查询，完成前 /health 返回 503
+    void setCacheWarmup(const string& snapshotPath, const string& queryLogPath,
+                        int snapshotInterval, size_t warmupQueries, int warmupThreads);
+
+    // 启用准入控制：同时处理的搜索请求超过 maxConcurrent 时降级为只返回标题，
+    // 预计完成时间超过请求截止时间或排队超过 maxQueue 时直接 503（缓存命中不受影响）
+    // 请求截止时间取自请求头 X-Deadline-Ms，缺省为 defaultDeadlineMs
+    void setAdmissionControl(int maxConcurrent, int maxQueue, int defaultDeadlineMs);
+
+    // 设置 /msearch 单次请求的查询数上限
+    void setMaxBatchQueries(size_t maxQueries);
+
+    // 启用慢查询日志：耗时超过 thresholdMs 的搜索请求及按 sampleRate 随机采样的请求
+    // 连同各阶段时间点与检索统计一起记录，最近 capacity 条可在 /debug/slow 查看
+    void setSlowQueryLog(const string& logPath, int thresholdMs, double sampleRate, size_t capacity);
+
     // 启动服务
     void start();
 
@@ -56,13 +138,83 @@ private:
     // 处理搜索请求
     string handleSearch(const string& query);
 
+    // 以 series 处理搜索请求，不阻塞网络线程：
+    //   检索（计算队列）-> 摘要并发读取（I/O 引擎，仅轻量异步模式）-> 摘要生成与序列化（计算队列）
+    void handleSearchSeries(const string& query, const SearchPage& page, unsigned fields,
+                            int deadlineMs, wfrest::HttpResp* resp, SeriesWork* series);
+    void retrieveStage(SearchContext& ctx);
+    void fetchSnippets(const shared_ptr<SearchContext>& ctx, wfrest::HttpResp* resp, SeriesWork* series);
+    void assembleStage(SearchContext& ctx);
+
+    // /search?explain=1：绕过响应缓存完整执行一次首页检索，返回分词、各词倒排表概况、
+    // 打分的倒排项数与文档数、缓存命中情况及各阶段耗时。诊断请求不改变服务状态：
+    // 不写入任何缓存，只用不调整 LRU 顺序、不计命中率的只读查找，检索不对热词缓存计频或准入，也不计入阶段直方图
+    void handleExplain(const string& query, unsigned fields, wfrest::HttpResp* resp, SeriesWork* series);
+
+    // 发送响应并归还准入名额
+    void completeSearch(SearchContext& ctx, wfrest::HttpResp* resp);
+
+    // 以 Prometheus 文本格式输出缓存（含分片级）、热词缓存与准入控制指标
+    void renderCacheMetrics(string& out);
+
+    // 各组件堆内存估算（字节）：加载后不变的索引与网页库在 start() 时统计一次并写日志，
+    // 缓存随请求变化，每次 /stats 时重新统计
+    vector<pair<string, size_t>> loadedMemory() const;
+    vector<pair<string, size_t>> cacheMemory();
+    void renderStats(string& out);
+
+    // 过载拒绝：503 + Retry-After
+    void rejectOverloaded(wfrest::HttpResp* resp);
+
+    // 批量搜索：查询去重、准入后在计算队列上查缓存，未命中的按分词结果分组，每组并行检索一次；
+    // 整批用到的词只解析一次，各组共享倒排表与热词条目的查找结果；准入降级时未命中的查询不生成摘要
+    void handleMultiSearch(const vector<string>& queries, unsigned fields, int deadlineMs,
+                           wfrest::HttpResp* resp, SeriesWork* series);
+    void completeMultiSearch(BatchContext& ctx, wfrest::HttpResp* resp);
+
     // 处理关键词推荐请求
     string handleSuggest(const string& query);
 
-    // 生成 JSON 响应
+    // 取一页排序结果：优先从排序列表缓存切片，游标超出缓存深度时从索引续查
+    vector<pair<int, double>> rankedPage(const vector<string>& queryWords, const SearchPage& page);
+
+    // 生成 JSON 响应；summaries 不为空时直接使用其中已生成的摘要
+    // 结果数达到 pageSize 时附带下一页游标；fields 为 ResponseField 位掩码
+    // recordMetrics 为 false 时不计入摘要 / 序列化阶段耗时统计（explain 使用）
     string generateResponse(const string& query,
                            const vector<pair<int, double>>& results,
-                           const vector<string>& queryWords);
+                           const vector<string>& queryWords,
+                           const vector<string>* summaries = nullptr,
+                           int pageSize = SearchPage::DEFAULT_SIZE,
+                           unsigned fields = FIELD_ALL,
+                           bool recordMetrics = true);
+
+    // 解析 fields 参数（逗号分隔的 id,score,title,url,summary），空串表示全部字段
+    static bool parseFields(const string& spec, unsigned& fields);
+
+    // 响应缓存 key：全部字段时即查询本身，否则附加字段集，窄字段请求缓存更小的响应
+    static string responseCacheKey(const string& query, unsigned fields);
+    static string queryOfCacheKey(const string& key);
+
+    // 游标编解码：得分的 IEEE 754 位模式与 docId 的十六进制拼接，解码得到的得分与原值逐位相同
+    static string encodeCursor(const pair<int, double>& last);
+    static bool decodeCursor(const string& cursor, SearchPage& page);
+
+    // 查询词排序后拼接（保留重复词），得分相同的查询共享同一 key
+    static string rankingKey(const vector<string>& queryWords);
+
+    // 启动预热与周期快照
+    void warmupCache();
+    void snapshotLoop();
+
+    // 查询词归一化（排序去重）后拼接，作为摘要缓存 key 的词集合部分
+    static string snippetTermKey(const vector<string>& queryWords);
+
+    // 先查摘要缓存，未命中时调用 compute 生成并回填
+    string lookupSummary(int docId, const string& termKey,
+                         const std::function<string()>& compute);
+    bool getCachedSummary(int docId, const string& termKey, string& summary);
+    void putCachedSummary(int docId, const string& termKey, const string& summary);
 
     // 生成推荐词 JSON 响应
     string generateSuggestResponse(const string& query,
@@ -81,6 +233,8 @@ private:
     unordered_map<int, WebPageMeta> _pageMetaLib;
     shared_ptr<ContentStore> _contentStore;
     bool _useLiteMode = false;
+    bool _asyncSnippet = false;
+    int _snippetDeadlineMs = 50;
 
     // 词典生成器和关键词推荐器
     shared_ptr<DictProducer> _dictProducer;
@@ -88,6 +242,31 @@ private:
 
     // LRU 缓存
     shared_ptr<SearchCache> _cache;
+    shared_ptr<SnippetCache> _snippetCache;
+    shared_ptr<RankedListCache> _rankedCache;
+    int _rankedDepth = 200;
+
+    // 缓存快照与预热
+    std::unique_ptr<CacheWarmer> _warmer;
+    int _snapshotInterval = 60;
+    size_t _warmupQueries = 0;
+    int _warmupThreads = 1;
+    std::atomic<bool> _ready{true};
+    std::thread _warmupThread;
+    std::thread _snapshotThread;
+
+    // 准入控制与请求截止时间
+    std::unique_ptr<AdmissionController> _admission;
+    int _requestDeadlineMs = 200;
+
+    // 批量搜索单次查询数上限
+    size_t _maxBatchQueries = 100;
+
+    // 慢查询日志
+    std::unique_ptr<SlowQueryLog> _slowLog;
+
+    // 加载完成时的组件内存统计
+    vector<pair<string, size_t>> _loadedMemory;
 
     // 优雅退出控制
     std::mutex _shutdownMutex;
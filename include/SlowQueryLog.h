@@ -0,0 +1,83 @@
+#ifndef __SLOW_QUERY_LOG_H__
+#define __SLOW_QUERY_LOG_H__
+
+#include "InvertIndex.h"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+
+using std::string;
+using std::vector;
+
+// 搜索请求处理过程中的时间点（相对请求到达）
+enum TracePoint {
+    TRACE_DEQUEUED = 0,     // 开始在计算线程上执行
+    TRACE_TOKENIZED,
+    TRACE_RETRIEVED,
+    TRACE_SNIPPETS_READ,    // 异步摘要读取完成或超时
+    TRACE_SERIALIZED,
+    TRACE_COUNT
+};
+
+// 一条慢查询记录
+struct SlowQueryRecord {
+    string query;
+    int from = 0;
+    int size = 0;
+    unsigned fields = 0;
+    bool degraded = false;
+    bool sampled = false;           // 因随机采样（而非超过阈值）被记录
+    size_t results = 0;
+    int64_t totalUs = 0;
+    int64_t trace[TRACE_COUNT];     // 各时间点（微秒），-1 表示未经过
+    SearchStats stats;              // 检索统计（翻页请求为空），各查询词概况只在记录时补全
+};
+
+// 慢查询日志：记录超过延迟阈值的请求以及少量随机采样请求
+// 最近 capacity 条保存在环形缓冲中供 /debug/slow 查看，同时由后台线程追加写入独立日志文件
+// 是否随机采样在请求开始时决定；未被记录的请求只付出一次阈值比较和一次线程私有随机数的开销
+class SlowQueryLog {
+public:
+    // logPath 为空时只保留内存环形缓冲
+    SlowQueryLog(const string& logPath, int64_t thresholdUs, double sampleRate, size_t capacity);
+    ~SlowQueryLog();
+
+    // 请求开始时决定是否随机采样（与耗时无关）
+    bool sample() const;
+    // 耗时 totalUs 的请求是否超过记录阈值
+    bool overThreshold(int64_t totalUs) const { return totalUs >= _thresholdUs; }
+
+    // 记录一条慢查询（序列化后放入环形缓冲和写入队列）
+    void record(const SlowQueryRecord& rec);
+
+    // 以 JSON 输出配置与环形缓冲中的记录（最新的在前）
+    void render(string& out);
+
+private:
+    static string serialize(const SlowQueryRecord& rec);
+    void writerLoop();
+
+private:
+    static constexpr size_t MAX_PENDING = 4096;  // 写入队列上限，磁盘跟不上时丢弃
+
+    string _logPath;
+    int64_t _thresholdUs;
+    uint32_t _sampleThreshold;      // 采样率折算到 32 位随机数的阈值
+
+    std::mutex _mutex;
+    vector<string> _ring;
+    size_t _next = 0;               // 下一个写入位置
+    uint64_t _recorded = 0;
+    uint64_t _dropped = 0;
+
+    vector<string> _pending;
+    std::condition_variable _cv;
+    bool _stopping = false;
+    std::thread _writer;
+};
+
+#endif // __SLOW_QUERY_LOG_H__
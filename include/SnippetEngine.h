@@ -0,0 +1,34 @@
+#ifndef __SNIPPET_ENGINE_H__
+#define __SNIPPET_ENGINE_H__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+// 摘要引擎：以句子为单位选取覆盖查询词最多的窗口，并高亮查询词
+// 句子边界在建库时预先计算（见 PageLib::storeSeparated / WebPage::processDoc），
+// 查询时只需一次扫描统计命中，不再对每个查询词从头 find
+class SnippetEngine {
+public:
+    // 摘要只在正文前 SCAN_BYTES 字节内选取，分句索引也只覆盖这一范围
+    static constexpr size_t SCAN_BYTES = 8192;
+
+    // 分句：返回每个句子的结束偏移（相对 text 起始，升序，最后一项为 text.size()）
+    static vector<uint32_t> segment(string_view text);
+
+    // 选取最佳摘要窗口
+    // ends/count 为预计算的句子结束偏移，为空时现场分句
+    // 返回 HTML 片段：正文中的 & < > 已转义，查询词以 <em></em> 包裹
+    static string bestWindow(string_view text, const uint32_t* ends, size_t count,
+                             const vector<string>& queryWords, size_t maxChars = 150);
+
+    // 截断到不超过 maxBytes 的完整 UTF-8 字符边界
+    static string_view truncateUtf8(string_view text, size_t maxBytes);
+};
+
+#endif // __SNIPPET_ENGINE_H__
@@ -0,0 +1,98 @@
+#ifndef __TERM_CACHE_H__
+#define __TERM_CACHE_H__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include "LRUCache.h"
+#include "InvertIndex.h"
+
+using std::string;
+using std::vector;
+using std::pair;
+using std::shared_ptr;
+
+// 热词缓存条目
+// prefix : 倒排表按权重降序的前 N 项（影响力前缀），用于顺序访问
+// byDoc  : 整条倒排表按 docId 升序排列，用于随机访问（二分查找）
+struct HotTermEntry {
+    vector<pair<int, double>> prefix;
+    vector<pair<int, double>> byDoc;
+    double tailBound = 0;   // 前缀之外的最大权重，0 表示前缀已覆盖整条倒排表
+
+    // 随机访问：返回该词在 docId 中的权重，不存在返回 0
+    double lookup(int docId) const;
+};
+
+// 词对交集缓存条目：两个热词同时出现的文档，按合并得分降序取前 N 项
+struct HotPairEntry {
+    vector<pair<int, double>> top;
+};
+
+// Count-Min Sketch 频率估计器：无锁计数，用于缓存准入
+class FrequencySketch {
+public:
+    explicit FrequencySketch(size_t width = 8192);
+
+    // 计数 +1，返回最新的频率估计
+    uint32_t increment(const string& key);
+
+    size_t memoryUsage() const { return mallocBytes(DEPTH * _width * sizeof(uint32_t)); }
+
+private:
+    // 周期性减半，让过期热词逐渐失去准入资格
+    void age();
+
+private:
+    static constexpr int DEPTH = 4;
+    size_t _width;
+    std::unique_ptr<std::atomic<uint32_t>[]> _counters;
+    std::atomic<uint64_t> _additions{0};
+};
+
+// 热词倒排缓存：词级前缀缓存 + 词对交集缓存，按访问频率准入
+class HotTermCache {
+public:
+    HotTermCache(size_t termCapacity, size_t pairCapacity,
+                 uint32_t admitThreshold = 3,
+                 size_t prefixLen = 1000,
+                 size_t minPostings = 1024);
+
+    // 获取词的缓存条目；未缓存时若访问频率达到阈值则立即构建并缓存
+    // 返回 nullptr 表示该词不是热词，调用方应走完整遍历
+    // admit 为 false 时只读取已缓存的条目：不计频、不准入、不调整 LRU 顺序，也不计入命中率
+    shared_ptr<const HotTermEntry> acquireTerm(const string& term,
+                                               const vector<InvertIndexItem>& postings,
+                                               bool admit = true);
+
+    // 获取词对交集条目（两个词都必须已是热词），admit 含义同上
+    shared_ptr<const HotPairEntry> acquirePair(const string& a, const HotTermEntry& entryA,
+                                               const string& b, const HotTermEntry& entryB,
+                                               bool admit = true);
+
+    size_t termCount() { return _terms.size(); }
+    size_t pairCount() { return _pairs.size(); }
+    double termHitRate() const { return _terms.hitRate(); }
+    double pairHitRate() const { return _pairs.hitRate(); }
+
+    // 内存占用估算（字节）：词级条目、词对条目与频率计数器
+    size_t memoryUsage();
+
+private:
+    shared_ptr<const HotTermEntry> buildTerm(const vector<InvertIndexItem>& postings) const;
+    shared_ptr<const HotPairEntry> buildPair(const HotTermEntry& a, const HotTermEntry& b) const;
+
+private:
+    ShardedLRUCache<string, shared_ptr<const HotTermEntry>> _terms;
+    ShardedLRUCache<string, shared_ptr<const HotPairEntry>> _pairs;
+    FrequencySketch _sketch;
+
+    bool _pairsEnabled;
+    uint32_t _admitThreshold;
+    size_t _prefixLen;
+    size_t _minPostings;
+};
+
+#endif // __TERM_CACHE_H__
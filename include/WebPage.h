@@ -2,11 +2,13 @@
 #define __WEB_PAGE_H__
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <cstdint>
 
 using std::string;
+using std::string_view;
 using std::vector;
 using std::map;
 
@@ -15,13 +17,18 @@ class SplitTool;
 // 网页类：表示一个文档
 class WebPage {
 public:
-    WebPage(const string& doc, SplitTool* splitTool);
+    // doc 只在构造期间读取，可以指向 mmap 映射的语料文件
+    WebPage(string_view doc, SplitTool* splitTool);
 
     int getDocId() const { return _docId; }
     string getTitle() const { return _title; }
     string getUrl() const { return _url; }
     string getContent() const { return _content; }
 
+    // 已校验 UTF-8 并做 JSON 转义的标题 / URL，响应中直接拼接
+    const string& getTitleJson() const { return _titleJson; }
+    const string& getUrlJson() const { return _urlJson; }
+
     // 获取词频统计
     map<string, int>& getWordsMap() { return _wordsMap; }
 
@@ -29,11 +36,25 @@ public:
     uint64_t getSimhash() const;
 
     // 处理文档：提取标题、内容、分词
-    void processDoc(const string& doc);
+    void processDoc(string_view doc);
+
+    // 文档中的标题 / URL / 正文，指向 doc 内部；缺少对应标签的字段为空
+    struct DocFields {
+        string_view title;
+        string_view url;
+        string_view content;
+    };
+    static DocFields extractFields(string_view doc);
 
     // 生成摘要（带查询词上下文）
     string getSummary(const vector<string>& queryWords) const;
 
+    // 正文前段的句子结束偏移
+    const vector<uint32_t>& getSentenceEnds() const { return _sentenceEnds; }
+
+    // 成员占用的堆内存估算（字节），不含对象本身
+    size_t memoryUsage() const;
+
     // SimHash 相关静态方法
     static int hammingDistance(uint64_t h1, uint64_t h2);
     static bool isSimilar(uint64_t h1, uint64_t h2, int threshold = 3);
@@ -45,9 +66,12 @@ private:
     string _title;
     string _url;
     string _content;
+    string _titleJson;
+    string _urlJson;
 
     SplitTool* _splitTool;
     map<string, int> _wordsMap;  // 词频统计
+    vector<uint32_t> _sentenceEnds;  // 正文前段的句子结束偏移（用于摘要窗口选取）
 };
 
 #endif // __WEB_PAGE_H__
@@ -0,0 +1,55 @@
+#include "AdmissionController.h"
+#include <algorithm>
+
+AdmissionController::AdmissionController(int maxConcurrent, int maxQueue)
+    : _maxConcurrent(std::max(maxConcurrent, 1))
+    , _maxQueue(std::max(maxQueue, 0)) {
+}
+
+int64_t AdmissionController::expectedLatencyUs(int inflight) const {
+    // 超出并发上限的请求按 _maxConcurrent 路并行消化，每一轮约一个服务时间
+    int64_t service = _serviceEwmaUs.load(std::memory_order_relaxed);
+    int64_t waiting = std::max(inflight + 1 - _maxConcurrent, 0);
+    int64_t modelledWait = service * waiting / _maxConcurrent;
+    // 同一计算队列里还有批量查询、诊断请求等不经准入的任务，实测排队耗时偏高时以实测为准
+    int64_t observedWait = _queueEwmaUs.load(std::memory_order_relaxed);
+    return service + std::max(modelledWait, observedWait);
+}
+
+int64_t AdmissionController::expectedLatencyUs() const {
+    return expectedLatencyUs(inflight());
+}
+
+AdmissionController::Decision AdmissionController::admit(int64_t deadlineUs) {
+    int current = _inflight.fetch_add(1, std::memory_order_acq_rel);
+
+    // 未饱和时总是接纳：即使服务时间估计已超过截止时间，也要靠新样本把估计拉回来
+    if (current < _maxConcurrent) {
+        _admitted.fetch_add(1, std::memory_order_relaxed);
+        return ADMIT;
+    }
+    if (current >= _maxConcurrent + _maxQueue || expectedLatencyUs(current) > deadlineUs) {
+        _inflight.fetch_sub(1, std::memory_order_acq_rel);
+        _rejected.fetch_add(1, std::memory_order_relaxed);
+        return REJECT;
+    }
+    _degraded.fetch_add(1, std::memory_order_relaxed);
+    return DEGRADE;
+}
+
+void AdmissionController::recordQueueTime(int64_t queueUs) {
+    updateEwma(_queueEwmaUs, queueUs);
+}
+
+void AdmissionController::release(int64_t serviceUs, bool recordService) {
+    if (recordService) {
+        updateEwma(_serviceEwmaUs, serviceUs);
+    }
+    _inflight.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void AdmissionController::updateEwma(std::atomic<int64_t>& ewma, int64_t sample) {
+    int64_t old = ewma.load(std::memory_order_relaxed);
+    int64_t next = (old == 0) ? sample : old + (sample - old) / 8;
+    ewma.store(next, std::memory_order_relaxed);
+}
@@ -0,0 +1,102 @@
+#include "BuildProfiler.h"
+#include "JsonWriter.h"
+#include "Logger.h"
+#include <fstream>
+#include <cstdio>
+#include <sys/resource.h>
+
+BuildProfiler* BuildProfiler::getInstance() {
+    static BuildProfiler instance;
+    return &instance;
+}
+
+const char* BuildProfiler::phaseName(BuildPhase phase) {
+    static const char* names[PHASE_COUNT] = {
+        "read", "extract", "tokenize", "dedup", "invert", "dictionary", "store"
+    };
+    return phase < PHASE_COUNT ? names[phase] : "unknown";
+}
+
+void BuildProfiler::begin() {
+    _start = std::chrono::steady_clock::now();
+    for (auto& ns : _phaseNs) {
+        ns.store(0);
+    }
+    _inputBytes.store(0);
+    _inputDocs.store(0);
+    _indexedDocs = 0;
+    _mappedInput.store(false);
+}
+
+// 进程峰值 RSS（字节），Linux 上 ru_maxrss 单位为 KB
+static size_t peakResidentBytes() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return (size_t)usage.ru_maxrss * 1024;
+}
+
+void BuildProfiler::report(const string& jsonPath) {
+    double totalSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+    double phaseSec[PHASE_COUNT];
+    double accounted = 0;
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        phaseSec[p] = _phaseNs[p].load() / 1e9;
+        accounted += phaseSec[p];
+    }
+    double otherSec = totalSec > accounted ? totalSec - accounted : 0;
+    uint64_t bytes = _inputBytes.load();
+    uint64_t docs = _inputDocs.load();
+    double docsPerSec = totalSec > 0 ? docs / totalSec : 0;
+    double mbPerSec = totalSec > 0 ? bytes / 1048576.0 / totalSec : 0;
+    size_t peakRss = peakResidentBytes();
+
+    char line[256];
+    LOG_INFO("=== Build Profile ===");
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        snprintf(line, sizeof(line), "  %-10s %9.2fs  %5.1f%%", phaseName((BuildPhase)p),
+                 phaseSec[p], totalSec > 0 ? phaseSec[p] * 100 / totalSec : 0);
+        LOG_INFO(line);
+    }
+    snprintf(line, sizeof(line), "  %-10s %9.2fs  %5.1f%%", "other", otherSec,
+             totalSec > 0 ? otherSec * 100 / totalSec : 0);
+    LOG_INFO(line);
+    snprintf(line, sizeof(line), "Total %.2fs: %zu docs read (%zu indexed), %.1f MB input, %.0f docs/s, %.2f MB/s, peak RSS %.1f MB",
+             totalSec, (size_t)docs, _indexedDocs, bytes / 1048576.0, docsPerSec, mbPerSec, peakRss / 1048576.0);
+    LOG_INFO(line);
+    bool mapped = _mappedInput.load();
+    if (mapped) {
+        LOG_INFO("  (corpus read via mmap: disk reads happen as page faults while parsing and are counted in extract)");
+    }
+
+    if (jsonPath.empty()) {
+        return;
+    }
+    string out;
+    JsonWriter writer(out);
+    writer.beginObject();
+    writer.key("total_sec").value(totalSec);
+    writer.key("phases_sec").beginObject();
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        writer.key(phaseName((BuildPhase)p)).value(phaseSec[p]);
+    }
+    writer.key("other").value(otherSec);
+    writer.endObject();
+    writer.key("read_in_extract").value(mapped);
+    writer.key("input_docs").value((size_t)docs);
+    writer.key("indexed_docs").value(_indexedDocs);
+    writer.key("input_bytes").value((size_t)bytes);
+    writer.key("docs_per_sec").value(docsPerSec);
+    writer.key("bytes_per_sec").value(totalSec > 0 ? bytes / totalSec : 0.0);
+    writer.key("peak_rss_bytes").value(peakRss);
+    writer.endObject();
+
+    std::ofstream ofs(jsonPath);
+    if (!ofs) {
+        LOG_WARN("Cannot write build profile: " + jsonPath);
+        return;
+    }
+    ofs << out << "\n";
+    LOG_INFO("Build profile written to " + jsonPath);
+}
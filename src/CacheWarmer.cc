@@ -0,0 +1,182 @@
+#include "CacheWarmer.h"
+#include "Logger.h"
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <sys/stat.h>
+
+using std::ifstream;
+using std::ofstream;
+using std::unordered_map;
+using std::unordered_set;
+using std::pair;
+
+CacheWarmer::CacheWarmer(const string& snapshotPath, const string& queryLogPath)
+    : _snapshotPath(snapshotPath)
+    , _queryLogPath(queryLogPath) {
+}
+
+CacheWarmer::~CacheWarmer() {
+    flushQueryLog();
+}
+
+void CacheWarmer::recordQuery(const string& query) {
+    // 快照与日志均按行存储，含换行的查询直接忽略
+    if (_queryLogPath.empty() || query.find('\n') != string::npos) {
+        return;
+    }
+    // 每个线程固定使用一个分片（按首次调用的顺序轮流分配）
+    static std::atomic<size_t> nextShard{0};
+    thread_local size_t shardIndex = nextShard.fetch_add(1, std::memory_order_relaxed) % PENDING_SHARDS;
+
+    PendingShard& shard = _pending[shardIndex];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.queries.size() >= MAX_PENDING / PENDING_SHARDS) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    shard.queries.push_back(query);
+}
+
+void CacheWarmer::flushQueryLog() {
+    if (_queryLogPath.empty()) return;
+
+    vector<string> batch;
+    for (auto& shard : _pending) {
+        vector<string> queries;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            queries.swap(shard.queries);
+        }
+        if (batch.empty()) {
+            batch.swap(queries);
+        } else {
+            std::move(queries.begin(), queries.end(), std::back_inserter(batch));
+        }
+    }
+    uint64_t dropped = _dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        LOG_WARN("Query log buffer full, dropped " + std::to_string(dropped) + " queries since last flush");
+    }
+    if (batch.empty()) return;
+
+    struct stat st;
+    if (stat(_queryLogPath.c_str(), &st) == 0 && (size_t)st.st_size > MAX_LOG_BYTES) {
+        std::rename(_queryLogPath.c_str(), (_queryLogPath + ".1").c_str());
+    }
+
+    ofstream ofs(_queryLogPath, std::ios::app);
+    if (!ofs) {
+        LOG_WARN("Cannot open query log: " + _queryLogPath);
+        return;
+    }
+    for (const auto& query : batch) {
+        ofs << query << "\n";
+    }
+}
+
+void CacheWarmer::saveSnapshot(const vector<string>& hotKeys) {
+    if (_snapshotPath.empty()) return;
+
+    string tmpPath = _snapshotPath + ".tmp";
+    {
+        ofstream ofs(tmpPath);
+        if (!ofs) {
+            LOG_WARN("Cannot create cache snapshot: " + tmpPath);
+            return;
+        }
+        for (const auto& key : hotKeys) {
+            if (key.find('\n') == string::npos) {
+                ofs << key << "\n";
+            }
+        }
+    }
+    if (std::rename(tmpPath.c_str(), _snapshotPath.c_str()) != 0) {
+        LOG_WARN("Cannot replace cache snapshot: " + _snapshotPath);
+        return;
+    }
+    LOG_DEBUG("Saved cache snapshot with " + std::to_string(hotKeys.size()) + " keys");
+}
+
+vector<string> CacheWarmer::loadSnapshot() const {
+    vector<string> keys;
+    ifstream ifs(_snapshotPath);
+    string line;
+    while (std::getline(ifs, line)) {
+        if (!line.empty()) {
+            keys.push_back(line);
+        }
+    }
+    return keys;
+}
+
+vector<string> CacheWarmer::topLoggedQueries(size_t limit) const {
+    unordered_map<string, size_t> freq;
+    ifstream ifs(_queryLogPath);
+    string line;
+    while (std::getline(ifs, line)) {
+        if (!line.empty()) {
+            freq[line]++;
+        }
+    }
+
+    vector<pair<string, size_t>> sorted(freq.begin(), freq.end());
+    size_t n = std::min(limit, sorted.size());
+    std::partial_sort(sorted.begin(), sorted.begin() + n, sorted.end(),
+                      [](const pair<string, size_t>& a, const pair<string, size_t>& b) {
+                          return a.second > b.second;
+                      });
+
+    vector<string> result;
+    result.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        result.push_back(sorted[i].first);
+    }
+    return result;
+}
+
+vector<string> CacheWarmer::loadWarmupQueries(size_t limit) const {
+    vector<string> result;
+    unordered_set<string> seen;
+
+    auto append = [&](const vector<string>& queries) {
+        for (const auto& q : queries) {
+            if (result.size() >= limit) break;
+            if (seen.insert(q).second) {
+                result.push_back(q);
+            }
+        }
+    };
+
+    if (!_snapshotPath.empty()) {
+        append(loadSnapshot());
+    }
+    if (!_queryLogPath.empty() && result.size() < limit) {
+        append(topLoggedQueries(limit));
+    }
+    return result;
+}
+
+void CacheWarmer::replay(const vector<string>& queries, int threads,
+                         const std::function<void(const string&)>& handler) {
+    threads = std::max(1, std::min(threads, (int)queries.size()));
+    std::atomic<size_t> next{0};
+
+    vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&]() {
+            size_t idx;
+            while ((idx = next.fetch_add(1)) < queries.size()) {
+                handler(queries[idx]);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
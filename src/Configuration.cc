@@ -1,6 +1,8 @@
 #include "Configuration.h"
 #include "Logger.h"
 #include <fstream>
+#include <stdexcept>
+#include <climits>
 
 using std::ifstream;
 
@@ -57,3 +59,87 @@ string Configuration::get(const string& key) const {
     }
     return "";
 }
+
+bool Configuration::has(const string& key) const {
+    return !get(key).empty();
+}
+
+string Configuration::get(const string& key, const string& defaultValue) const {
+    string value = get(key);
+    return value.empty() ? defaultValue : value;
+}
+
+static std::invalid_argument badValue(const string& key, const string& value, const char* expected) {
+    return std::invalid_argument("Config item " + key + " = \"" + value + "\" is not " + expected);
+}
+
+// 整个值必须是一个整数，不接受 "12abc" 这样的前缀匹配
+static long long parseInteger(const string& key, const string& value) {
+    size_t pos = 0;
+    long long result = 0;
+    try {
+        result = std::stoll(value, &pos);
+    } catch (const std::exception&) {
+        pos = 0;
+    }
+    if (pos == 0 || pos != value.size()) {
+        throw badValue(key, value, "an integer");
+    }
+    return result;
+}
+
+int Configuration::getInt(const string& key, int defaultValue) const {
+    string value = get(key);
+    if (value.empty()) {
+        return defaultValue;
+    }
+    long long result = parseInteger(key, value);
+    if (result < INT_MIN || result > INT_MAX) {
+        throw badValue(key, value, "in int range");
+    }
+    return (int)result;
+}
+
+size_t Configuration::getSize(const string& key, size_t defaultValue) const {
+    string value = get(key);
+    if (value.empty()) {
+        return defaultValue;
+    }
+    long long result = parseInteger(key, value);
+    if (result < 0) {
+        throw badValue(key, value, "a non-negative integer");
+    }
+    return (size_t)result;
+}
+
+double Configuration::getDouble(const string& key, double defaultValue) const {
+    string value = get(key);
+    if (value.empty()) {
+        return defaultValue;
+    }
+    size_t pos = 0;
+    double result = 0;
+    try {
+        result = std::stod(value, &pos);
+    } catch (const std::exception&) {
+        pos = 0;
+    }
+    if (pos == 0 || pos != value.size()) {
+        throw badValue(key, value, "a number");
+    }
+    return result;
+}
+
+bool Configuration::getBool(const string& key, bool defaultValue) const {
+    string value = get(key);
+    if (value.empty()) {
+        return defaultValue;
+    }
+    if (value == "1" || value == "true") {
+        return true;
+    }
+    if (value == "0" || value == "false") {
+        return false;
+    }
+    throw badValue(key, value, "a boolean (1/0/true/false)");
+}
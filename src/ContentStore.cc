@@ -0,0 +1,135 @@
+#include "ContentStore.h"
+#include "WebPageMeta.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+ContentStore::ContentStore(const string& contentFilePath, size_t mmapLimit)
+    : _filePath(contentFilePath) {
+    _fd = ::open(_filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (_fd < 0) {
+        LOG_ERROR("Cannot open content file: " + _filePath);
+        return;
+    }
+
+    struct stat st;
+    if (fstat(_fd, &st) != 0) {
+        LOG_ERROR("Cannot stat content file: " + _filePath);
+        return;
+    }
+    _fileSize = st.st_size;
+
+    if (_fileSize == 0 || _fileSize > mmapLimit) {
+        LOG_INFO("Content store: pread mode (" + std::to_string(_fileSize) + " bytes)");
+        return;
+    }
+
+    void* addr = mmap(nullptr, _fileSize, PROT_READ, MAP_SHARED, _fd, 0);
+    if (addr == MAP_FAILED) {
+        LOG_WARN("mmap content file failed, falling back to pread: " + string(strerror(errno)));
+        return;
+    }
+    // 摘要读取是随机小范围访问，关闭预读避免无谓的 I/O 和页缓存占用
+    madvise(addr, _fileSize, MADV_RANDOM);
+    _data = static_cast<const char*>(addr);
+    LOG_INFO("Content store: mmap mode (" + std::to_string(_fileSize) + " bytes)");
+}
+
+ContentStore::~ContentStore() {
+    if (_data) {
+        munmap(const_cast<char*>(_data), _fileSize);
+    }
+    if (_segData) {
+        munmap(const_cast<uint32_t*>(_segData), _segCount * sizeof(uint32_t));
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+    }
+}
+
+string_view ContentStore::readContent(size_t offset, size_t length, string& scratch) const {
+    if (offset >= _fileSize) {
+        return string_view();
+    }
+    length = std::min(length, _fileSize - offset);
+
+    if (_data) {
+        return string_view(_data + offset, length);
+    }
+
+    // pread 不改变文件偏移，多线程共享同一个 fd 是安全的
+    scratch.resize(length);
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = pread(_fd, &scratch[done], length - done, offset + done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += n;
+    }
+    scratch.resize(done);
+    return string_view(scratch);
+}
+
+bool ContentStore::loadSegments(const string& segFilePath) {
+    int fd = ::open(segFilePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_WARN("No sentence index, snippets will segment on the fly: " + segFilePath);
+        return false;
+    }
+
+    struct stat st;
+    size_t size = (fstat(fd, &st) == 0) ? st.st_size : 0;
+    void* addr = (size >= sizeof(uint32_t))
+        ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0)
+        : MAP_FAILED;
+    ::close(fd);
+
+    if (addr == MAP_FAILED) {
+        LOG_WARN("Cannot map sentence index: " + segFilePath);
+        return false;
+    }
+    madvise(addr, size, MADV_RANDOM);
+    _segData = static_cast<const uint32_t*>(addr);
+    _segCount = size / sizeof(uint32_t);
+    LOG_INFO("Sentence index loaded: " + std::to_string(_segCount) + " boundaries");
+    return true;
+}
+
+const uint32_t* ContentStore::segments(size_t segOffset, uint32_t segCount) const {
+    if (!_segData || segCount == 0 || segOffset + segCount > _segCount) {
+        return nullptr;
+    }
+    return _segData + segOffset;
+}
+
+string ContentStore::getSummary(size_t offset, size_t length,
+                                const vector<string>& queryWords,
+                                size_t maxChars) const {
+    // 只读取需要的部分，而不是整个正文
+    size_t readLength = std::min(length, SUMMARY_READ_BYTES);
+
+    string scratch;
+    return summarize(readContent(offset, readLength, scratch), queryWords,
+                     nullptr, 0, maxChars);
+}
+
+string ContentStore::getSummary(const WebPageMeta& meta,
+                                const vector<string>& queryWords,
+                                size_t maxChars) const {
+    size_t readLength = std::min(meta.contentLength, SUMMARY_READ_BYTES);
+
+    string scratch;
+    return summarize(readContent(meta.contentOffset, readLength, scratch), queryWords,
+                     segments(meta.segOffset, meta.segCount), meta.segCount, maxChars);
+}
+
+string ContentStore::summarize(string_view text, const vector<string>& queryWords,
+                               const uint32_t* ends, size_t count,
+                               size_t maxChars) {
+    return SnippetEngine::bestWindow(text, ends, count, queryWords, maxChars);
+}
@@ -0,0 +1,269 @@
+#include "CorpusGenerator.h"
+#include "Logger.h"
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+#include <unordered_set>
+
+using std::ifstream;
+using std::ofstream;
+
+static uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+CorpusGenerator::CorpusGenerator(const CorpusOptions& options)
+    : _options(options) {
+    uint64_t seed = options.seed;
+    for (auto& s : _state) {
+        s = splitmix64(seed);
+    }
+
+    if (!_options.vocabPath.empty()) {
+        loadVocabulary(_options.vocabPath);
+    }
+    if (_vocab.empty()) {
+        generateVocabulary();
+    }
+    _wordTable = buildAlias(zipfWeights(_vocab.size(), _options.zipfExponent));
+    LOG_INFO("Corpus generator: " + std::to_string(_vocab.size()) + " words, seed "
+             + std::to_string(_options.seed));
+}
+
+uint64_t CorpusGenerator::next() {
+    uint64_t result = rotl(_state[1] * 5, 7) * 9;
+    uint64_t t = _state[1] << 17;
+    _state[2] ^= _state[0];
+    _state[3] ^= _state[1];
+    _state[1] ^= _state[2];
+    _state[0] ^= _state[3];
+    _state[2] ^= t;
+    _state[3] = rotl(_state[3], 45);
+    return result;
+}
+
+double CorpusGenerator::uniform() {
+    return (next() >> 11) * 0x1.0p-53;
+}
+
+double CorpusGenerator::normal() {
+    double u1 = 1.0 - uniform();  // (0, 1]
+    double u2 = uniform();
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * M_PI * u2);
+}
+
+void CorpusGenerator::loadVocabulary(const string& path) {
+    ifstream ifs(path);
+    if (!ifs) {
+        LOG_WARN("Cannot open vocabulary file: " + path + ", generating random words");
+        return;
+    }
+    std::unordered_set<string> seen;
+    string line;
+    while (_vocab.size() < _options.vocabSize && std::getline(ifs, line)) {
+        std::istringstream iss(line);
+        string word;
+        if (iss >> word && seen.insert(word).second) {
+            _vocab.push_back(word);
+        }
+    }
+}
+
+void CorpusGenerator::generateVocabulary() {
+    // 词长分布：单字 10%，双字 60%，三字 20%，四字 10%；字取自常用汉字区
+    std::unordered_set<string> seen;
+    while (_vocab.size() < _options.vocabSize) {
+        double r = uniform();
+        int len = r < 0.1 ? 1 : r < 0.7 ? 2 : r < 0.9 ? 3 : 4;
+        string word;
+        for (int i = 0; i < len; ++i) {
+            uint32_t cp = 0x4E00 + (uint32_t)(next() % (0x9FA5 - 0x4E00 + 1));
+            word += (char)(0xE0 | (cp >> 12));
+            word += (char)(0x80 | ((cp >> 6) & 0x3F));
+            word += (char)(0x80 | (cp & 0x3F));
+        }
+        if (seen.insert(word).second) {
+            _vocab.push_back(word);
+        }
+    }
+}
+
+vector<double> CorpusGenerator::zipfWeights(size_t n, double exponent) {
+    vector<double> weights(n);
+    for (size_t i = 0; i < n; ++i) {
+        weights[i] = 1.0 / std::pow((double)(i + 1), exponent);
+    }
+    return weights;
+}
+
+CorpusGenerator::AliasTable CorpusGenerator::buildAlias(const vector<double>& weights) {
+    size_t n = weights.size();
+    AliasTable table;
+    table.prob.assign(n, 1.0);
+    table.alias.assign(n, 0);
+    if (n == 0) return table;
+
+    double sum = 0;
+    for (double w : weights) sum += w;
+
+    vector<double> scaled(n);
+    vector<uint32_t> small, large;
+    for (size_t i = 0; i < n; ++i) {
+        scaled[i] = weights[i] * n / sum;
+        (scaled[i] < 1.0 ? small : large).push_back((uint32_t)i);
+    }
+    while (!small.empty() && !large.empty()) {
+        uint32_t s = small.back(); small.pop_back();
+        uint32_t l = large.back(); large.pop_back();
+        table.prob[s] = scaled[s];
+        table.alias[s] = l;
+        scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+        (scaled[l] < 1.0 ? small : large).push_back(l);
+    }
+    // 剩余项的概率因浮点误差略偏离 1，直接取 1
+    return table;
+}
+
+size_t CorpusGenerator::sample(const AliasTable& table) {
+    size_t i = next() % table.prob.size();
+    return uniform() < table.prob[i] ? i : table.alias[i];
+}
+
+size_t CorpusGenerator::docWordCount() {
+    double words = std::exp(_options.docLenMu + _options.docLenSigma * normal());
+    return std::min(std::max((size_t)std::llround(words), _options.minDocWords), _options.maxDocWords);
+}
+
+void CorpusGenerator::appendText(string& out, const vector<uint32_t>& words, bool title) {
+    if (title) {
+        for (uint32_t w : words) out += _vocab[w];
+        return;
+    }
+    // 正文按 8~20 词分句，长句中间加逗号
+    size_t sentenceLen = 8 + next() % 13;
+    size_t pos = 0;
+    for (uint32_t w : words) {
+        out += _vocab[w];
+        ++pos;
+        if (pos == sentenceLen) {
+            out += "。";
+            sentenceLen = 8 + next() % 13;
+            pos = 0;
+        } else if (sentenceLen > 12 && pos == sentenceLen / 2) {
+            out += "，";
+        }
+    }
+    if (pos > 0) out += "。";
+}
+
+size_t CorpusGenerator::writeCorpus(const string& path) {
+    ofstream ofs(path, std::ios::binary);
+    if (!ofs) {
+        LOG_ERROR("Cannot create corpus file: " + path);
+        return 0;
+    }
+
+    // 最近生成的文档，近似重复从中挑选原文
+    struct Recent {
+        vector<uint32_t> title;
+        vector<uint32_t> content;
+    };
+    const size_t RECENT = 1024;
+    vector<Recent> recent;
+    recent.reserve(RECENT);
+
+    size_t duplicates = 0;
+    uint64_t bytes = 0;
+    string doc;
+    for (size_t d = 0; d < _options.docs; ++d) {
+        Recent cur;
+        if (!recent.empty() && uniform() < _options.duplicateRate) {
+            cur = recent[next() % recent.size()];
+            for (auto& w : cur.content) {
+                if (uniform() < _options.duplicateEdits) {
+                    w = (uint32_t)sample(_wordTable);
+                }
+            }
+            duplicates++;
+        } else {
+            size_t titleWords = 4 + next() % 9;
+            for (size_t i = 0; i < titleWords; ++i) cur.title.push_back((uint32_t)sample(_wordTable));
+            size_t contentWords = docWordCount();
+            cur.content.reserve(contentWords);
+            for (size_t i = 0; i < contentWords; ++i) cur.content.push_back((uint32_t)sample(_wordTable));
+        }
+
+        doc.clear();
+        doc += "<doc>\n<url>http://news.synthetic.local/";
+        doc += std::to_string(d + 1);
+        doc += ".html</url>\n<docno>";
+        doc += std::to_string(d + 1);
+        doc += "</docno>\n<contenttitle>";
+        appendText(doc, cur.title, true);
+        doc += "</contenttitle>\n<content>";
+        appendText(doc, cur.content, false);
+        doc += "</content>\n</doc>\n";
+        ofs << doc;
+        bytes += doc.size();
+
+        if (recent.size() < RECENT) {
+            recent.push_back(std::move(cur));
+        } else {
+            recent[d % RECENT] = std::move(cur);
+        }
+        if ((d + 1) % 100000 == 0) {
+            LOG_INFO("Generated " + std::to_string(d + 1) + " docs");
+        }
+    }
+
+    LOG_INFO("Corpus written: " + path + ", " + std::to_string(_options.docs) + " docs ("
+             + std::to_string(duplicates) + " near-duplicates), " + std::to_string(bytes >> 20) + " MB");
+    return _options.docs;
+}
+
+size_t CorpusGenerator::writeQueryLog(const string& path) {
+    ofstream ofs(path);
+    if (!ofs) {
+        LOG_ERROR("Cannot create query log: " + path);
+        return 0;
+    }
+
+    // 先生成不同查询的集合（1~3 个词，跳过最高频的停用词式词项），再按 Zipf 热度抽样成日志
+    const size_t SKIP_TOP = std::min((size_t)10, _vocab.size() - 1);
+    size_t poolSize = std::max((size_t)1000, _options.queries / 20);
+    vector<string> pool;
+    std::unordered_set<string> seen;
+    size_t attempts = 0;
+    while (pool.size() < poolSize && attempts++ < poolSize * 10) {
+        double r = uniform();
+        int words = r < 0.5 ? 1 : r < 0.85 ? 2 : 3;
+        string query;
+        for (int i = 0; i < words; ++i) {
+            size_t w;
+            do {
+                w = sample(_wordTable);
+            } while (w < SKIP_TOP);
+            query += _vocab[w];
+        }
+        if (seen.insert(query).second) {
+            pool.push_back(query);
+        }
+    }
+
+    AliasTable queryTable = buildAlias(zipfWeights(pool.size(), _options.queryExponent));
+    for (size_t i = 0; i < _options.queries; ++i) {
+        ofs << pool[sample(queryTable)] << "\n";
+    }
+
+    LOG_INFO("Query log written: " + path + ", " + std::to_string(_options.queries) + " queries over "
+             + std::to_string(pool.size()) + " distinct");
+    return _options.queries;
+}
@@ -2,6 +2,7 @@
 #include "SplitTool.h"
 #include "WebPage.h"
 #include "Logger.h"
+#include "MemoryUsage.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
@@ -220,3 +221,18 @@ void DictProducer::loadIndex(const string& filePath) {
 
     LOG_INFO("Loaded index with " + std::to_string(_charIndex.size()) + " characters");
 }
+
+size_t DictProducer::memoryUsage() const {
+    size_t bytes = _dict.size() * treeNodeBytes<map<string, int>::value_type>();
+    for (const auto& entry : _dict) {
+        bytes += heapBytes(entry.first);
+    }
+    bytes += _charIndex.size() * treeNodeBytes<map<string, set<string>>::value_type>();
+    for (const auto& entry : _charIndex) {
+        bytes += heapBytes(entry.first) + entry.second.size() * treeNodeBytes<string>();
+        for (const auto& word : entry.second) {
+            bytes += heapBytes(word);
+        }
+    }
+    return bytes;
+}
@@ -1,10 +1,16 @@
 #include "InvertIndex.h"
 #include "WebPage.h"
+#include "TermCache.h"
 #include "Logger.h"
+#include "MemoryUsage.h"
 #include <fstream>
 #include <sstream>
 #include <cmath>
 #include <algorithm>
+#include <queue>
+#include <unordered_set>
+#include <functional>
+#include <limits>
 
 using std::ifstream;
 using std::ofstream;
@@ -18,6 +24,20 @@ InvertIndex::InvertIndex()
     , _avgDocLen(0) {
 }
 
+InvertIndex::~InvertIndex() = default;
+
+void InvertIndex::enableTermCache(size_t termCapacity, size_t pairCapacity,
+                                  uint32_t admitThreshold, size_t prefixLen, size_t minPostings) {
+    if (termCapacity == 0) {
+        _termCache.reset();
+        return;
+    }
+    _termCache.reset(new HotTermCache(termCapacity, pairCapacity,
+                                      admitThreshold, prefixLen, minPostings));
+    LOG_INFO("Hot term cache enabled: " + std::to_string(termCapacity) + " terms, "
+             + std::to_string(pairCapacity) + " pairs");
+}
+
 void InvertIndex::build(vector<shared_ptr<WebPage>>& pages) {
     _totalDocs = pages.size();
     if (_totalDocs == 0) {
@@ -88,49 +108,403 @@ double InvertIndex::calculateBM25(int termFreq, int docLen, int docFreq) {
     return idf * tfNorm;
 }
 
-vector<pair<int, double>> InvertIndex::search(const vector<string>& queryWords, int topK) {
+vector<pair<int, double>> InvertIndex::search(const vector<string>& queryWords, int topK,
+                                              SearchStats* stats, bool admit) {
+    if (queryWords.empty()) return {};
+
+    if (_termCache) {
+        vector<pair<int, double>> results;
+        if (searchWithTermCache(queryWords, topK, results, stats, admit)) {
+            return results;
+        }
+    }
+    return searchExhaustive(queryWords, topK, nullptr, stats);
+}
+
+ResolvedTerms InvertIndex::resolveTerms(const vector<vector<string>>& queries) {
+    ResolvedTerms resolved;
+    for (const auto& words : queries) {
+        for (const auto& word : words) {
+            auto res = resolved.terms.emplace(word, ResolvedTerms::Term());
+            if (!res.second) {
+                continue;
+            }
+            auto it = _invertIndex.find(word);
+            if (it == _invertIndex.end()) {
+                continue;
+            }
+            res.first->second.postings = &it->second;
+            if (_termCache) {
+                res.first->second.hot = _termCache->acquireTerm(word, it->second);
+            }
+        }
+    }
+    return resolved;
+}
+
+vector<pair<int, double>> InvertIndex::search(const vector<string>& queryWords, int topK,
+                                              const ResolvedTerms& resolved) {
     if (queryWords.empty()) return {};
 
+    if (_termCache) {
+        vector<pair<int, double>> results;
+        if (searchWithTermCache(queryWords, topK, results, nullptr, true, &resolved)) {
+            return results;
+        }
+    }
+    return searchExhaustive(queryWords, topK, nullptr, nullptr, &resolved);
+}
+
+const vector<InvertIndexItem>* InvertIndex::findPostings(const string& word, const ResolvedTerms* resolved) const {
+    if (resolved) {
+        auto it = resolved->terms.find(word);
+        return it != resolved->terms.end() ? it->second.postings : nullptr;
+    }
+    auto it = _invertIndex.find(word);
+    return it != _invertIndex.end() ? &it->second : nullptr;
+}
+
+void InvertIndex::describeTerms(const vector<string>& queryWords, SearchStats& stats) const {
+    map<string, int> termMult = countTerms(queryWords);
+    stats.terms.clear();
+    for (const auto& word : queryWords) {
+        auto found = std::find_if(stats.terms.begin(), stats.terms.end(),
+                                  [&](const SearchStats::TermStats& t) { return t.term == word; });
+        if (found != stats.terms.end()) {
+            continue;
+        }
+        SearchStats::TermStats term;
+        term.term = word;
+        auto mult = termMult.find(word);
+        term.count = mult->second;
+        size_t rank = std::distance(termMult.begin(), mult);
+        term.hot = rank < 64 && (stats.hotTermMask >> rank & 1);
+        // 倒排表按权重降序，首项即最大权重
+        auto it = _invertIndex.find(word);
+        if (it != _invertIndex.end() && !it->second.empty()) {
+            term.postings = it->second.size();
+            term.maxImpact = it->second.front().weight;
+        }
+        stats.terms.push_back(term);
+    }
+}
+
+vector<pair<int, double>> InvertIndex::searchAfter(const vector<string>& queryWords, int topK,
+                                                   double afterScore, int afterDocId) {
+    if (queryWords.empty()) return {};
+
+    pair<int, double> after(afterDocId, afterScore);
+    return searchExhaustive(queryWords, topK, &after);
+}
+
+map<string, int> InvertIndex::countTerms(const vector<string>& queryWords) {
+    map<string, int> termMult;
+    for (const auto& word : queryWords) {
+        termMult[word]++;
+    }
+    return termMult;
+}
+
+vector<pair<int, double>> InvertIndex::searchExhaustive(const vector<string>& queryWords, int topK,
+                                                        const pair<int, double>* after,
+                                                        SearchStats* stats,
+                                                        const ResolvedTerms* resolved) {
     int maxDocId = _docLens.empty() ? 0 : _docLens.rbegin()->first;
     vector<double> scores(maxDocId + 1, 0.0);
     vector<int> dirtyDocIds;
 
-    for (const auto& word : queryWords) {
-        auto it = _invertIndex.find(word);
-        if (it != _invertIndex.end()) {
-            for (const auto& item : it->second) {
+    size_t postingsScored = 0;
+    for (const auto& tm : countTerms(queryWords)) {
+        const vector<InvertIndexItem>* postings = findPostings(tm.first, resolved);
+        if (postings) {
+            for (const auto& item : *postings) {
                 if (scores[item.docId] == 0.0) {
                     dirtyDocIds.push_back(item.docId);
                 }
-                scores[item.docId] += item.weight;
+                scores[item.docId] += item.weight * tm.second;
             }
+            postingsScored += postings->size();
         }
     }
 
+    if (stats) {
+        stats->path = "exhaustive";
+        stats->postingsScored += postingsScored;
+        stats->docsTouched += dirtyDocIds.size();
+    }
+
     vector<pair<int, double>> results;
     results.reserve(dirtyDocIds.size());
     for (int docId : dirtyDocIds) {
-        results.emplace_back(docId, scores[docId]);
+        pair<int, double> result(docId, scores[docId]);
+        if (after && !rankBefore(*after, result)) {
+            continue;
+        }
+        results.push_back(result);
     }
 
     if (results.size() > (size_t)topK) {
-        partial_sort(results.begin(),
-                     results.begin() + topK,
-                     results.end(),
-                     [](const pair<int, double>& a, const pair<int, double>& b) {
-                         return a.second > b.second;
-                     });
+        partial_sort(results.begin(), results.begin() + topK, results.end(), rankBefore);
         results.resize(topK);
     } else {
-        sort(results.begin(), results.end(),
-             [](const pair<int, double>& a, const pair<int, double>& b) {
-                 return a.second > b.second;
-             });
+        sort(results.begin(), results.end(), rankBefore);
     }
 
     return results;
 }
 
+bool InvertIndex::searchWithTermCache(const vector<string>& queryWords, int topK,
+                                      vector<pair<int, double>>& results, SearchStats* stats, bool admit,
+                                      const ResolvedTerms* batchTerms) {
+    // 查询词去重并记录出现次数；按字典序遍历，热词与冷词各自保持规范累加顺序
+    struct HotTerm {
+        const string* word;
+        shared_ptr<const HotTermEntry> entry;
+        int mult;
+    };
+    map<string, int> termMult = countTerms(queryWords);
+
+    vector<HotTerm> hotTerms;
+    vector<pair<const vector<InvertIndexItem>*, int>> coldTerms;
+    vector<const string*> coldWords;
+    size_t rank = 0;
+    for (const auto& tm : termMult) {
+        size_t termRank = rank++;
+        const vector<InvertIndexItem>* postings = findPostings(tm.first, batchTerms);
+        if (!postings) continue;
+
+        shared_ptr<const HotTermEntry> entry;
+        if (batchTerms) {
+            entry = batchTerms->terms.at(tm.first).hot;
+        } else {
+            entry = _termCache->acquireTerm(tm.first, *postings, admit);
+        }
+        if (entry) {
+            hotTerms.push_back({&tm.first, entry, tm.second});
+            if (stats && termRank < 64) {
+                stats->hotTermMask |= (uint64_t)1 << termRank;
+            }
+        } else {
+            coldTerms.emplace_back(postings, tm.second);
+            coldWords.push_back(&tm.first);
+        }
+    }
+    if (hotTerms.empty()) {
+        return false;
+    }
+
+    // 预判：在做任何打分之前估算阈值算法的随机访问次数，贵过顺序累加各热词整条倒排表时直接完整遍历。
+    // 第 K 个候选得分的下界取某个热词前缀或词对交集第 K 项的得分（其中前 K 篇文档的得分都不低于它），
+    // 深度阈值（各词当前深度权重之和）降到下界以下即可终止；直到前缀耗尽都降不下来则无法提前终止。
+    size_t sequentialCost = 0;
+    size_t maxDepth = 0;
+    double kthLowerBound = 0;
+    for (const auto& hot : hotTerms) {
+        const auto& prefix = hot.entry->prefix;
+        sequentialCost += hot.entry->byDoc.size();
+        maxDepth = std::max(maxDepth, prefix.size());
+        if (prefix.size() >= (size_t)topK) {
+            kthLowerBound = std::max(kthLowerBound, prefix[topK - 1].second * hot.mult);
+        }
+    }
+    auto depthThreshold = [&](size_t depth) {
+        double threshold = 0;
+        for (const auto& hot : hotTerms) {
+            const auto& prefix = hot.entry->prefix;
+            threshold += (depth < prefix.size() ? prefix[depth].second : hot.entry->tailBound) * hot.mult;
+        }
+        return threshold;
+    };
+    // 词对条目只取不打分：种子文档的随机访问计入预判
+    vector<shared_ptr<const HotPairEntry>> pairEntries;
+    size_t seedDocs = 0;
+    for (size_t i = 0; i < hotTerms.size(); ++i) {
+        for (size_t j = i + 1; j < hotTerms.size(); ++j) {
+            auto pairEntry = _termCache->acquirePair(*hotTerms[i].word, *hotTerms[i].entry,
+                                                     *hotTerms[j].word, *hotTerms[j].entry, admit);
+            if (!pairEntry) continue;
+            if (pairEntry->top.size() >= (size_t)topK) {
+                kthLowerBound = std::max(kthLowerBound, pairEntry->top[topK - 1].second);
+            }
+            seedDocs += std::min(pairEntry->top.size(), (size_t)topK);
+            pairEntries.push_back(std::move(pairEntry));
+        }
+    }
+    size_t stopDepth = 0;
+    while (stopDepth <= maxDepth && depthThreshold(stopDepth) >= kthLowerBound) {
+        stopDepth++;
+    }
+    size_t predictedDocs = std::max(stopDepth, (size_t)topK) * hotTerms.size() + seedDocs;
+    for (const auto& cold : coldTerms) {
+        predictedDocs += cold.first->size();
+    }
+    if (stopDepth > maxDepth || predictedDocs * hotTerms.size() * RANDOM_ACCESS_COST > sequentialCost) {
+        if (stats) {
+            stats->fallback = true;
+        }
+        return false;
+    }
+    if (stats) {
+        stats->path = "threshold";
+    }
+
+    // 冷词倒排表较短，按 docId 排序后与热词一样随机访问
+    size_t postingsScored = 0;
+    vector<HotTermEntry> coldEntries(coldTerms.size());
+    for (size_t c = 0; c < coldTerms.size(); ++c) {
+        auto& byDoc = coldEntries[c].byDoc;
+        byDoc.reserve(coldTerms[c].first->size());
+        for (const auto& item : *coldTerms[c].first) {
+            byDoc.emplace_back(item.docId, item.weight);
+        }
+        sort(byDoc.begin(), byDoc.end());
+    }
+
+    // 全部查询词按规范顺序排列，精确打分时逐词累加
+    vector<pair<const HotTermEntry*, int>> scoringTerms;
+    scoringTerms.reserve(termMult.size());
+    size_t hotPos = 0, coldPos = 0;
+    while (hotPos < hotTerms.size() || coldPos < coldTerms.size()) {
+        if (coldPos == coldTerms.size()
+            || (hotPos < hotTerms.size() && *hotTerms[hotPos].word < *coldWords[coldPos])) {
+            scoringTerms.emplace_back(hotTerms[hotPos].entry.get(), hotTerms[hotPos].mult);
+            hotPos++;
+        } else {
+            scoringTerms.emplace_back(&coldEntries[coldPos], coldTerms[coldPos].second);
+            coldPos++;
+        }
+    }
+
+    // 预判可能偏乐观：运行中累计的随机访问代价一旦超出顺序累加的代价，就不再继续阈值算法，转入补全
+    size_t randomLookups = 0;
+    auto overBudget = [&]() { return randomLookups * RANDOM_ACCESS_COST > sequentialCost; };
+
+    // 文档精确得分：按规范顺序累加各词权重，与完整遍历逐位一致（缺少的词加 0 不改变结果）
+    auto exactScore = [&](int docId) {
+        double score = 0;
+        for (const auto& term : scoringTerms) {
+            score += term.first->lookup(docId) * term.second;
+        }
+        postingsScored += scoringTerms.size();
+        randomLookups += scoringTerms.size();
+        return score;
+    };
+
+    // 堆顶为当前 TopK 中排名最靠后的文档（与 rankBefore 顺序一致，同分时 docId 大者先出堆）
+    using Scored = pair<int, double>;
+    std::priority_queue<Scored, vector<Scored>, decltype(&rankBefore)> heap(&rankBefore);
+    std::unordered_set<int> resolved;
+    auto consider = [&](int docId) {
+        if (!resolved.insert(docId).second) return;
+        Scored scored(docId, exactScore(docId));
+        if ((int)heap.size() < topK) {
+            heap.push(scored);
+        } else if (rankBefore(scored, heap.top())) {
+            heap.pop();
+            heap.push(scored);
+        }
+    };
+    auto heapFull = [&]() { return (int)heap.size() >= topK; };
+
+    // 1. 冷词命中的文档全部精确打分
+    for (const auto& cold : coldEntries) {
+        for (const auto& item : cold.byDoc) {
+            consider(item.first);
+        }
+        postingsScored += cold.byDoc.size();
+    }
+
+    // 2. 词对交集作为种子：交集文档通常得分最高，能尽早抬高堆顶阈值
+    for (size_t p = 0; p < pairEntries.size() && !overBudget(); ++p) {
+        size_t seeds = std::min(pairEntries[p]->top.size(), (size_t)topK);
+        for (size_t k = 0; k < seeds; ++k) {
+            consider(pairEntries[p]->top[k].first);
+        }
+    }
+
+    // 3. 按深度轮询各热词前缀，未见过的文档得分上界为各词当前深度权重之和
+    bool converged = false;
+    for (size_t depth = 0; depth <= maxDepth && !overBudget(); ++depth) {
+        double threshold = depthThreshold(depth);
+        // 严格大于：未见文档得分可能恰好等于阈值且 docId 更小
+        if (threshold <= 0 || (heapFull() && heap.top().second > threshold)) {
+            converged = true;
+            break;
+        }
+        if (depth == maxDepth) {
+            break;
+        }
+        for (const auto& hot : hotTerms) {
+            if (depth < hot.entry->prefix.size()) {
+                consider(hot.entry->prefix[depth].first);
+                postingsScored++;
+            }
+        }
+    }
+
+    if (!converged) {
+        // 补全：冷词命中的文档在第 1 步已全部精确打分，其余文档只含热词得分，
+        // 按规范顺序累加各热词的整条倒排表即可，已打分的文档不再重复计算
+        int maxDocId = _docLens.empty() ? 0 : _docLens.rbegin()->first;
+        vector<double> hotScores(maxDocId + 1, 0.0);
+        vector<int> dirtyDocIds;
+        // 已打分的文档标记为负值：不会被当作新文档收集，也不必逐篇查 resolved
+        for (int docId : resolved) {
+            hotScores[docId] = -std::numeric_limits<double>::infinity();
+        }
+        for (const auto& hot : hotTerms) {
+            for (const auto& item : hot.entry->byDoc) {
+                if (hotScores[item.first] == 0.0) {
+                    dirtyDocIds.push_back(item.first);
+                }
+                hotScores[item.first] += item.second * hot.mult;
+            }
+            postingsScored += hot.entry->byDoc.size();
+        }
+        for (int docId : dirtyDocIds) {
+            Scored scored(docId, hotScores[docId]);
+            if ((int)heap.size() < topK) {
+                heap.push(scored);
+            } else if (rankBefore(scored, heap.top())) {
+                heap.pop();
+                heap.push(scored);
+            }
+        }
+        if (stats) {
+            stats->fallback = true;
+            stats->docsTouched += dirtyDocIds.size();
+        }
+    }
+
+    if (stats) {
+        stats->postingsScored += postingsScored;
+        stats->docsTouched += resolved.size();
+    }
+
+    results.clear();
+    results.reserve(heap.size());
+    while (!heap.empty()) {
+        if (heap.top().second > 0) {
+            results.push_back(heap.top());
+        }
+        heap.pop();
+    }
+    std::reverse(results.begin(), results.end());
+    return true;
+}
+
+size_t InvertIndex::postingsMemory() const {
+    size_t bytes = hashTableBytes(_invertIndex);
+    for (const auto& entry : _invertIndex) {
+        bytes += heapBytes(entry.first) + vectorHeapBytes(entry.second);
+    }
+    return bytes;
+}
+
+size_t InvertIndex::docLensMemory() const {
+    return _docLens.size() * treeNodeBytes<map<int, int>::value_type>();
+}
+
 void InvertIndex::store(const string& filePath) {
     ofstream ofs(filePath);
     if (!ofs) {
@@ -0,0 +1,182 @@
+#include "JsonWriter.h"
+#include <charconv>
+#include <cmath>
+
+JsonWriter& JsonWriter::beginObject() {
+    separator();
+    _out += '{';
+    ++_depth;
+    _hasElement &= ~(1ULL << (_depth & 63));
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    --_depth;
+    _out += '}';
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    separator();
+    _out += '[';
+    ++_depth;
+    _hasElement &= ~(1ULL << (_depth & 63));
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    --_depth;
+    _out += ']';
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(string_view name) {
+    separator();
+    _out += '"';
+    escape(_out, name);
+    _out += "\":";
+    _afterKey = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(string_view s) {
+    separator();
+    _out += '"';
+    escape(_out, s);
+    _out += '"';
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(int64_t v) {
+    separator();
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), v);
+    _out.append(buf, res.ptr - buf);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(size_t v) {
+    separator();
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), v);
+    _out.append(buf, res.ptr - buf);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double v) {
+    separator();
+    if (!std::isfinite(v)) {
+        _out += "null";  // 与 nlohmann::json 行为一致
+        return *this;
+    }
+    // 最短往返表示
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof(buf), v);
+    _out.append(buf, res.ptr - buf);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool v) {
+    separator();
+    _out += v ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::raw(string_view json) {
+    separator();
+    _out.append(json.data(), json.size());
+    return *this;
+}
+
+JsonWriter& JsonWriter::escapedValue(string_view escaped) {
+    separator();
+    _out += '"';
+    _out.append(escaped.data(), escaped.size());
+    _out += '"';
+    return *this;
+}
+
+void JsonWriter::separator() {
+    if (_afterKey) {
+        _afterKey = false;
+        return;
+    }
+    uint64_t bit = 1ULL << (_depth & 63);
+    if (_hasElement & bit) {
+        _out += ',';
+    }
+    _hasElement |= bit;
+}
+
+// 校验 p 处的 UTF-8 序列，合法返回字节数，非法返回 0（拒绝超长编码、代理区和超出 U+10FFFF）
+static inline size_t validUtf8At(const unsigned char* p, size_t remain) {
+    unsigned char c = p[0];
+    if (c >= 0xC2 && c <= 0xDF) {
+        return (remain >= 2 && (p[1] & 0xC0) == 0x80) ? 2 : 0;
+    }
+    if (c >= 0xE0 && c <= 0xEF) {
+        if (remain < 3 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80) return 0;
+        if (c == 0xE0 && p[1] < 0xA0) return 0;   // 超长编码
+        if (c == 0xED && p[1] >= 0xA0) return 0;  // UTF-16 代理区
+        return 3;
+    }
+    if (c >= 0xF0 && c <= 0xF4) {
+        if (remain < 4 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80 || (p[3] & 0xC0) != 0x80) return 0;
+        if (c == 0xF0 && p[1] < 0x90) return 0;
+        if (c == 0xF4 && p[1] >= 0x90) return 0;
+        return 4;
+    }
+    return 0;
+}
+
+void JsonWriter::escape(string& out, string_view s) {
+    static const char* hex = "0123456789abcdef";
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(s.data());
+    size_t n = s.size();
+    size_t runStart = 0;
+
+    // 无需处理的字节成段追加
+    auto flush = [&](size_t end) {
+        if (end > runStart) {
+            out.append(s.data() + runStart, end - runStart);
+        }
+    };
+
+    size_t i = 0;
+    while (i < n) {
+        unsigned char c = p[i];
+        if (c >= 0x20 && c != '"' && c != '\\' && c < 0x80) {
+            ++i;
+            continue;
+        }
+        if (c >= 0x80) {
+            size_t len = validUtf8At(p + i, n - i);
+            if (len > 0) {
+                i += len;
+                continue;
+            }
+            flush(i);
+            ++i;  // 非法字节，丢弃
+            runStart = i;
+            continue;
+        }
+
+        flush(i);
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 0xF];
+        }
+        ++i;
+        runStart = i;
+    }
+    flush(n);
+}
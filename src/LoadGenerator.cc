@@ -0,0 +1,307 @@
+#include "LoadGenerator.h"
+#include "JsonWriter.h"
+#include "Logger.h"
+#include "wfrest/json.hpp"
+#include "workflow/WFTaskFactory.h"
+#include <fstream>
+#include <random>
+#include <thread>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+using std::ifstream;
+using std::chrono::steady_clock;
+using nlohmann::json;
+
+struct LoadGenerator::Request {
+    steady_clock::time_point scheduled;
+    steady_clock::time_point sent;
+};
+
+static int64_t microsBetween(steady_clock::time_point from, steady_clock::time_point to) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+static HistogramSnapshot snapshotOf(const LatencyHistogram& hist) {
+    HistogramSnapshot snap;
+    snap.counts.assign(LatencyHistogram::BUCKET_COUNT, 0);
+    for (int i = 0; i < LatencyHistogram::BUCKET_COUNT; ++i) {
+        snap.counts[i] = hist.counts[i].load(std::memory_order_relaxed);
+        snap.total += snap.counts[i];
+    }
+    snap.sumUs = hist.sumUs.load(std::memory_order_relaxed);
+    return snap;
+}
+
+// HTTP 状态码；网络层失败（连接失败、超时）记为 0
+static int statusOf(WFHttpTask* task) {
+    if (task->get_state() != WFT_STATE_SUCCESS) {
+        return 0;
+    }
+    const char* code = task->get_resp()->get_status_code();
+    return code ? std::atoi(code) : 0;
+}
+
+LoadGenerator::LoadGenerator(const LoadOptions& options)
+    : _options(options) {
+    _options.concurrency = std::max(_options.concurrency, 1);
+}
+
+size_t LoadGenerator::loadQueries(const string& path) {
+    ifstream ifs(path);
+    if (!ifs) {
+        LOG_ERROR("Cannot open query log: " + path);
+        return 0;
+    }
+    string line;
+    while (std::getline(ifs, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty()) {
+            _queries.push_back(line);
+        }
+    }
+    LOG_INFO("Loaded " + std::to_string(_queries.size()) + " queries from " + path);
+    return _queries.size();
+}
+
+string LoadGenerator::baseUrl() const {
+    return "http://" + _options.host + ":" + std::to_string(_options.port);
+}
+
+string LoadGenerator::urlEncode(const string& raw) {
+    static const char* HEX = "0123456789ABCDEF";
+    string encoded;
+    encoded.reserve(raw.size() * 3);
+    for (unsigned char c : raw) {
+        if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            encoded += (char)c;
+        } else {
+            encoded += '%';
+            encoded += HEX[c >> 4];
+            encoded += HEX[c & 0xF];
+        }
+    }
+    return encoded;
+}
+
+string LoadGenerator::fetch(const string& path) {
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool done = false;
+    string body;
+
+    WFHttpTask* task = WFTaskFactory::create_http_task(baseUrl() + path, 0, 0,
+        [&](WFHttpTask* task) {
+            const void* data;
+            size_t size;
+            string result;
+            if (statusOf(task) != 0 && task->get_resp()->get_parsed_body(&data, &size)) {
+                result.assign((const char*)data, size);
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            body = std::move(result);
+            done = true;
+            cond.notify_one();
+        });
+    task->set_receive_timeout(_options.timeoutMs);
+    task->start();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [&]() { return done; });
+    return body;
+}
+
+bool LoadGenerator::fetchCacheCounters(uint64_t& hits, uint64_t& lookups) {
+    string body = fetch("/health");
+    if (body.empty()) {
+        return false;
+    }
+    try {
+        json health = json::parse(body);
+        if (!health.contains("cache_hits") || !health.contains("cache_lookups")) {
+            return false;
+        }
+        hits = health["cache_hits"].get<uint64_t>();
+        lookups = health["cache_lookups"].get<uint64_t>();
+        return true;
+    } catch (const std::exception& e) {
+        LOG_WARN(string("Cannot parse /health response: ") + e.what());
+        return false;
+    }
+}
+
+void LoadGenerator::issue(size_t index, steady_clock::time_point scheduled) {
+    const string& query = _queries[index % _queries.size()];
+    auto request = new Request{scheduled, steady_clock::now()};
+
+    WFHttpTask* task = WFTaskFactory::create_http_task(
+        baseUrl() + _options.path + "?q=" + urlEncode(query), 0, 0,
+        [this](WFHttpTask* task) {
+            onResponse(static_cast<Request*>(task->user_data), statusOf(task));
+        });
+    task->user_data = request;
+    task->set_receive_timeout(_options.timeoutMs);
+    task->start();
+}
+
+void LoadGenerator::onResponse(Request* request, int status) {
+    auto now = steady_clock::now();
+    int64_t latencyUs = microsBetween(request->scheduled, now);
+    _latency.record(latencyUs);
+    _service.record(microsBetween(request->sent, now));
+    delete request;
+
+    uint64_t prev = _maxLatencyUs.load(std::memory_order_relaxed);
+    while ((uint64_t)latencyUs > prev
+           && !_maxLatencyUs.compare_exchange_weak(prev, (uint64_t)latencyUs, std::memory_order_relaxed)) {
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _statusCounts[status]++;
+    _inflight--;
+    _cond.notify_all();
+}
+
+LoadReport LoadGenerator::run() {
+    LoadReport report;
+    report.targetRate = _options.rate;
+    if (_queries.empty()) {
+        LOG_ERROR("No queries to replay");
+        return report;
+    }
+
+    uint64_t hitsBefore = 0, lookupsBefore = 0;
+    bool haveBefore = fetchCacheCounters(hitsBefore, lookupsBefore);
+    if (!haveBefore) {
+        LOG_WARN("Cannot read cache counters from " + baseUrl() + "/health, cache hit rate will not be reported");
+    }
+
+    size_t total = _options.requests > 0 ? _options.requests : _queries.size();
+    LOG_INFO("Replaying " + std::to_string(total) + " requests against " + baseUrl() + _options.path
+             + (_options.rate > 0 ? ", rate " + std::to_string((int)_options.rate) + "/s" : ", closed loop")
+             + ", concurrency " + std::to_string(_options.concurrency));
+
+    // 到达时刻按泊松过程预先确定，与服务端响应快慢无关（开环）；槽满时请求在客户端排队，延迟照常从计划时刻算起
+    std::mt19937_64 rng(_options.seed);
+    std::exponential_distribution<double> interArrival(_options.rate > 0 ? _options.rate : 1.0);
+
+    auto start = steady_clock::now();
+    auto deadline = start + std::chrono::microseconds((int64_t)(_options.durationSec * 1e6));
+    auto scheduled = start;
+    size_t sent = 0;
+    for (; sent < total; ++sent) {
+        if (_options.rate > 0) {
+            scheduled += std::chrono::nanoseconds((int64_t)(interArrival(rng) * 1e9));
+            std::this_thread::sleep_until(scheduled);
+        }
+        if (_options.durationSec > 0 && steady_clock::now() >= deadline) {
+            break;
+        }
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cond.wait(lock, [this]() { return _inflight < _options.concurrency; });
+            _inflight++;
+        }
+        issue(sent, _options.rate > 0 ? scheduled : steady_clock::now());
+
+        if ((sent + 1) % 10000 == 0) {
+            LOG_INFO("Sent " + std::to_string(sent + 1) + " requests");
+        }
+    }
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cond.wait(lock, [this]() { return _inflight == 0; });
+    }
+    report.elapsedSec = std::chrono::duration<double>(steady_clock::now() - start).count();
+
+    report.sent = sent;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        report.statusCounts = _statusCounts;
+    }
+    for (const auto& entry : report.statusCounts) {
+        if (entry.first >= 200 && entry.first < 300) {
+            report.completed += entry.second;
+        } else if (entry.first == 503) {
+            report.rejected += entry.second;
+        } else {
+            report.failed += entry.second;
+        }
+    }
+    report.achievedQps = report.elapsedSec > 0 ? report.completed / report.elapsedSec : 0;
+    report.latency = snapshotOf(_latency);
+    report.service = snapshotOf(_service);
+    report.maxLatencyUs = _maxLatencyUs.load();
+
+    uint64_t hitsAfter = 0, lookupsAfter = 0;
+    if (haveBefore && fetchCacheCounters(hitsAfter, lookupsAfter) && lookupsAfter >= lookupsBefore) {
+        report.haveCacheStats = true;
+        report.cacheLookups = lookupsAfter - lookupsBefore;
+        report.cacheHitRate = report.cacheLookups
+            ? (double)(hitsAfter - hitsBefore) / report.cacheLookups : 0;
+    }
+    return report;
+}
+
+void LoadReport::log() const {
+    char line[256];
+    LOG_INFO("=== Load Test Report ===");
+    snprintf(line, sizeof(line), "Requests: %zu sent, %zu ok, %zu rejected (503), %zu failed in %.2fs",
+             sent, completed, rejected, failed, elapsedSec);
+    LOG_INFO(line);
+    snprintf(line, sizeof(line), "Throughput: %.1f QPS (target %s)", achievedQps,
+             targetRate > 0 ? std::to_string((int)targetRate).c_str() : "closed loop");
+    LOG_INFO(line);
+    snprintf(line, sizeof(line), "Latency ms: p50 %.2f, p90 %.2f, p99 %.2f, p999 %.2f, max %.2f, mean %.2f",
+             latency.quantile(0.5) / 1000.0, latency.quantile(0.9) / 1000.0,
+             latency.quantile(0.99) / 1000.0, latency.quantile(0.999) / 1000.0,
+             maxLatencyUs / 1000.0, latency.total ? latency.sumUs / 1000.0 / latency.total : 0.0);
+    LOG_INFO(line);
+    snprintf(line, sizeof(line), "Service ms (excl. client queueing): p50 %.2f, p99 %.2f, p999 %.2f",
+             service.quantile(0.5) / 1000.0, service.quantile(0.99) / 1000.0, service.quantile(0.999) / 1000.0);
+    LOG_INFO(line);
+    if (haveCacheStats) {
+        snprintf(line, sizeof(line), "Result cache hit rate during run: %.1f%% of %zu lookups",
+                 cacheHitRate * 100, (size_t)cacheLookups);
+        LOG_INFO(line);
+    }
+}
+
+void LoadReport::toJson(string& out) const {
+    JsonWriter writer(out);
+    writer.beginObject();
+    writer.key("sent").value(sent);
+    writer.key("completed").value(completed);
+    writer.key("rejected").value(rejected);
+    writer.key("failed").value(failed);
+    writer.key("status").beginObject();
+    for (const auto& entry : statusCounts) {
+        writer.key(std::to_string(entry.first)).value(entry.second);
+    }
+    writer.endObject();
+    writer.key("elapsed_sec").value(elapsedSec);
+    writer.key("target_rate").value(targetRate);
+    writer.key("qps").value(achievedQps);
+
+    auto writeLatency = [&writer](const char* name, const HistogramSnapshot& snap) {
+        writer.key(name).beginObject();
+        writer.key("p50").value(snap.quantile(0.5) / 1000.0);
+        writer.key("p90").value(snap.quantile(0.9) / 1000.0);
+        writer.key("p99").value(snap.quantile(0.99) / 1000.0);
+        writer.key("p999").value(snap.quantile(0.999) / 1000.0);
+        writer.key("mean").value(snap.total ? snap.sumUs / 1000.0 / snap.total : 0.0);
+        writer.endObject();
+    };
+    writeLatency("latency_ms", latency);
+    writeLatency("service_ms", service);
+    writer.key("max_latency_ms").value(maxLatencyUs / 1000.0);
+
+    if (haveCacheStats) {
+        writer.key("cache_lookups").value((size_t)cacheLookups);
+        writer.key("cache_hit_rate").value(cacheHitRate);
+    }
+    writer.endObject();
+}
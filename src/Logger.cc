@@ -4,16 +4,39 @@
 #include <log4cpp/RollingFileAppender.hh>
 #include <log4cpp/PatternLayout.hh>
 #include <log4cpp/Priority.hh>
+#include <log4cpp/LoggingEvent.hh>
+#include <log4cpp/TimeStamp.hh>
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+// 单个线程的日志环形缓冲：所属线程写 head，写线程读 tail
+struct Logger::ThreadBuffer {
+    static constexpr size_t CAPACITY = 1024;
+
+    struct Record {
+        int priority = 0;
+        int64_t timeUs = 0;     // 产生时的墙上时间，写出时作为日志时间戳
+        string message;
+    };
+
+    Record slots[CAPACITY];
+    std::atomic<size_t> head{0};
+    std::atomic<size_t> tail{0};
+    std::atomic<bool> alive{true};  // 所属线程退出后置 false，排空后由写线程回收
+};
 
 Logger* Logger::_pInstance = nullptr;
 
 Logger::Logger()
     : _category(nullptr)
-    , _initialized(false) {
+    , _initialized(false)
+    , _level(log4cpp::Priority::DEBUG) {
 }
 
 Logger::~Logger() {
+    shutdown();
     if (_initialized) {
         log4cpp::Category::shutdown();
     }
@@ -66,39 +89,191 @@ void Logger::init(const string& configPath) {
 
         _initialized = true;
     }
+
+    // 级别只在初始化时读取一次，之后的判断不再访问 log4cpp
+    _level.store(_category->getChainedPriority(), std::memory_order_relaxed);
+    _writer = std::thread(&Logger::writerLoop, this);
+    _async.store(true, std::memory_order_release);
+    std::atexit([]() { Logger::getInstance()->shutdown(); });
 }
 
 void Logger::debug(const string& msg) {
-    if (!_initialized) {
-        init();
-    }
-    _category->debug(msg);
+    log(log4cpp::Priority::DEBUG, msg);
 }
 
 void Logger::info(const string& msg) {
-    if (!_initialized) {
-        init();
-    }
-    _category->info(msg);
+    log(log4cpp::Priority::INFO, msg);
 }
 
 void Logger::warn(const string& msg) {
-    if (!_initialized) {
-        init();
-    }
-    _category->warn(msg);
+    log(log4cpp::Priority::WARN, msg);
 }
 
 void Logger::error(const string& msg) {
-    if (!_initialized) {
-        init();
-    }
-    _category->error(msg);
+    log(log4cpp::Priority::ERROR, msg);
 }
 
 void Logger::fatal(const string& msg) {
+    log(log4cpp::Priority::FATAL, msg);
+    flush();
+}
+
+static int64_t wallTimeUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+Logger::ThreadBuffer& Logger::local() {
+    // 线程退出时标记缓冲已失效，缓冲本身由注册表持有，剩余日志仍会被写出
+    struct Holder {
+        std::shared_ptr<ThreadBuffer> buffer;
+        ~Holder() {
+            if (buffer) buffer->alive.store(false, std::memory_order_release);
+        }
+    };
+    thread_local Holder holder;
+    if (!holder.buffer) {
+        holder.buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(_registryMutex);
+        _registry.push_back(holder.buffer);
+    }
+    return *holder.buffer;
+}
+
+void Logger::log(int priority, const string& msg) {
     if (!_initialized) {
         init();
     }
-    _category->fatal(msg);
+
+    int64_t now = wallTimeUs();
+    // 先登记再检查 _async（与 shutdown 中先清 _async 再等计数归零对应，均为 seq_cst）：
+    // 要么这里看到写线程已停止走同步写出，要么 shutdown 等到本条写入缓冲后再做最后一次汇总
+    _producers.fetch_add(1);
+    if (!_async.load()) {
+        _producers.fetch_sub(1);
+        // 写线程已停止：先写出缓冲中更早的日志，再同步写出本条
+        std::lock_guard<std::mutex> lock(_drainMutex);
+        drainLocked();
+        append(priority, now, msg);
+        return;
+    }
+
+    ThreadBuffer& buffer = local();
+    size_t head = buffer.head.load(std::memory_order_relaxed);
+    size_t used = head - buffer.tail.load(std::memory_order_acquire);
+    if (used >= ThreadBuffer::CAPACITY) {
+        // 缓冲已满（写线程跟不上）：唤醒写线程并短暂等待，本线程不做文件 I/O；等不到空位就丢弃
+        _wakeCv.notify_one();
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(FULL_WAIT_US);
+        do {
+            std::this_thread::yield();
+            used = head - buffer.tail.load(std::memory_order_acquire);
+        } while (used >= ThreadBuffer::CAPACITY && std::chrono::steady_clock::now() < deadline);
+        if (used >= ThreadBuffer::CAPACITY) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            _droppedTotal.fetch_add(1, std::memory_order_relaxed);
+            _producers.fetch_sub(1, std::memory_order_release);
+            return;
+        }
+    }
+
+    ThreadBuffer::Record& record = buffer.slots[head % ThreadBuffer::CAPACITY];
+    record.priority = priority;
+    record.timeUs = now;
+    record.message = msg;
+    buffer.head.store(head + 1, std::memory_order_release);
+    _producers.fetch_sub(1, std::memory_order_release);
+
+    // 写线程定时汇总；缓冲过半或出现错误日志时提前唤醒
+    if (used + 1 >= ThreadBuffer::CAPACITY / 2 || priority <= log4cpp::Priority::ERROR) {
+        _wakeCv.notify_one();
+    }
+}
+
+void Logger::append(int priority, int64_t timeUs, const string& msg) {
+    log4cpp::LoggingEvent event(_category->getName(), msg, "", priority);
+    event.timeStamp = log4cpp::TimeStamp((unsigned)(timeUs / 1000000), (unsigned)(timeUs % 1000000));
+
+    std::lock_guard<std::mutex> lock(_appendMutex);
+    _category->callAppenders(event);
+}
+
+void Logger::drain() {
+    std::lock_guard<std::mutex> drainLock(_drainMutex);
+    drainLocked();
+}
+
+void Logger::drainLocked() {
+    vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(_registryMutex);
+        buffers = _registry;
+    }
+
+    // 汇总各线程的日志，按产生时间排序后写出（同一线程内顺序不变）
+    vector<ThreadBuffer::Record> batch;
+    for (const auto& buffer : buffers) {
+        size_t tail = buffer->tail.load(std::memory_order_relaxed);
+        size_t head = buffer->head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) {
+            batch.push_back(std::move(buffer->slots[tail % ThreadBuffer::CAPACITY]));
+        }
+        buffer->tail.store(tail, std::memory_order_release);
+    }
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const ThreadBuffer::Record& a, const ThreadBuffer::Record& b) {
+                         return a.timeUs < b.timeUs;
+                     });
+    for (const auto& record : batch) {
+        append(record.priority, record.timeUs, record.message);
+    }
+    uint64_t dropped = _dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        append(log4cpp::Priority::WARN, wallTimeUs(),
+               "Log buffer full, dropped " + std::to_string(dropped) + " messages");
+    }
+
+    // 回收已退出且排空的线程缓冲
+    std::lock_guard<std::mutex> lock(_registryMutex);
+    _registry.erase(std::remove_if(_registry.begin(), _registry.end(),
+                                   [](const std::shared_ptr<ThreadBuffer>& buffer) {
+                                       return !buffer->alive.load(std::memory_order_acquire)
+                                           && buffer->tail.load(std::memory_order_relaxed)
+                                              == buffer->head.load(std::memory_order_acquire);
+                                   }),
+                    _registry.end());
+}
+
+void Logger::flush() {
+    if (_initialized) {
+        drain();
+    }
+}
+
+void Logger::writerLoop() {
+    std::unique_lock<std::mutex> lock(_wakeMutex);
+    while (!_stopping) {
+        _wakeCv.wait_for(lock, std::chrono::milliseconds(50));
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
+
+void Logger::shutdown() {
+    _async.store(false);
+    // 等已通过 _async 检查的线程写完缓冲；写线程仍在运行，缓冲满而等待空位的线程也能完成
+    while (_producers.load(std::memory_order_acquire) != 0) {
+        _wakeCv.notify_one();
+        std::this_thread::yield();
+    }
+    {
+        std::lock_guard<std::mutex> lock(_wakeMutex);
+        _stopping = true;
+    }
+    _wakeCv.notify_one();
+    if (_writer.joinable()) {
+        _writer.join();
+    }
+    flush();
 }
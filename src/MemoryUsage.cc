@@ -0,0 +1,26 @@
+#include "MemoryUsage.h"
+#include <fstream>
+#include <malloc.h>
+#include <unistd.h>
+
+ProcessMemory processMemory() {
+    ProcessMemory mem;
+
+    std::ifstream statm("/proc/self/statm");
+    size_t totalPages = 0;
+    size_t residentPages = 0;
+    if (statm >> totalPages >> residentPages) {
+        mem.residentBytes = residentPages * (size_t)sysconf(_SC_PAGESIZE);
+    }
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+#else
+    // 旧版 glibc 只有 int 字段，超过 2GB 会回绕
+    struct mallinfo info = mallinfo();
+#endif
+    mem.heapMapped = (size_t)info.hblkhd;
+    mem.heapInUse = (size_t)info.uordblks + mem.heapMapped;
+    mem.heapFree = (size_t)info.fordblks;
+    return mem;
+}
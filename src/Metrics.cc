@@ -0,0 +1,238 @@
+#include "Metrics.h"
+#include <cstdio>
+
+void LatencyHistogram::record(int64_t us) {
+    uint64_t value = us > 0 ? (uint64_t)us : 0;
+    counts[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    sumUs.fetch_add(value, std::memory_order_relaxed);
+}
+
+int LatencyHistogram::bucketOf(uint64_t us) {
+    if (us < (uint64_t)SUB_COUNT) {
+        return (int)us;
+    }
+    if (us > 0xFFFFFFFFULL) {
+        us = 0xFFFFFFFFULL;
+    }
+    int exp = 63 - __builtin_clzll(us);
+    int sub = (int)((us >> (exp - SUB_BITS)) & (SUB_COUNT - 1));
+    return (exp - SUB_BITS + 1) * SUB_COUNT + sub;
+}
+
+uint64_t LatencyHistogram::bucketUpper(int bucket) {
+    if (bucket < SUB_COUNT) {
+        return (uint64_t)bucket + 1;
+    }
+    int exp = bucket / SUB_COUNT + SUB_BITS - 1;
+    int sub = bucket % SUB_COUNT;
+    uint64_t width = 1ULL << (exp - SUB_BITS);
+    return ((uint64_t)(SUB_COUNT + sub) << (exp - SUB_BITS)) + width;
+}
+
+uint64_t HistogramSnapshot::quantile(double q) const {
+    if (total == 0) return 0;
+    uint64_t rank = (uint64_t)(q * total);
+    if (rank >= total) rank = total - 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen > rank) {
+            return LatencyHistogram::bucketUpper((int)i);
+        }
+    }
+    return LatencyHistogram::bucketUpper((int)counts.size() - 1);
+}
+
+Metrics* Metrics::getInstance() {
+    // 局部静态变量的初始化是线程安全的，计算线程可能在 main 之外首次调用
+    static Metrics instance;
+    return &instance;
+}
+
+Metrics::ThreadHistograms& Metrics::local() {
+    thread_local ThreadHistograms* histograms = nullptr;
+    if (!histograms) {
+        // 由注册表持有所有权，线程退出后数据仍可导出
+        auto owned = std::make_shared<ThreadHistograms>();
+        histograms = owned.get();
+        std::lock_guard<std::mutex> lock(_registryMutex);
+        _registry.push_back(std::move(owned));
+    }
+    return *histograms;
+}
+
+void Metrics::record(Stage stage, int64_t us) {
+    local().stages[stage].record(us);
+}
+
+static int64_t nowSecond() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Metrics::countRequest(Endpoint endpoint) {
+    _requests[endpoint].fetch_add(1, std::memory_order_relaxed);
+
+    int64_t sec = nowSecond();
+    RateSlot& slot = _rates[endpoint][sec % RATE_SLOTS];
+    int64_t old = slot.second.load(std::memory_order_relaxed);
+    if (old != sec && slot.second.compare_exchange_strong(old, sec)) {
+        // 槽位进入新的一秒，由抢到的线程清零；并发时个别计数可能丢失，对 QPS 影响可忽略
+        slot.count.store(0, std::memory_order_relaxed);
+    }
+    slot.count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::countError(int status) {
+    if (status >= 500) {
+        _serverErrors.fetch_add(1, std::memory_order_relaxed);
+    } else if (status >= 400) {
+        _clientErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+HistogramSnapshot Metrics::snapshot(Stage stage) const {
+    HistogramSnapshot snap;
+    snap.counts.assign(LatencyHistogram::BUCKET_COUNT, 0);
+
+    std::lock_guard<std::mutex> lock(_registryMutex);
+    for (const auto& thread : _registry) {
+        const LatencyHistogram& hist = thread->stages[stage];
+        for (int i = 0; i < LatencyHistogram::BUCKET_COUNT; ++i) {
+            uint64_t c = hist.counts[i].load(std::memory_order_relaxed);
+            snap.counts[i] += c;
+            snap.total += c;
+        }
+        snap.sumUs += hist.sumUs.load(std::memory_order_relaxed);
+    }
+    return snap;
+}
+
+double Metrics::qps(Endpoint endpoint, int windowSec) const {
+    if (windowSec <= 0 || windowSec >= RATE_SLOTS) return 0;
+    int64_t now = nowSecond();
+    uint64_t total = 0;
+    for (int64_t sec = now - windowSec; sec < now; ++sec) {
+        const RateSlot& slot = _rates[endpoint][sec % RATE_SLOTS];
+        if (slot.second.load(std::memory_order_relaxed) == sec) {
+            total += slot.count.load(std::memory_order_relaxed);
+        }
+    }
+    return (double)total / windowSec;
+}
+
+const char* Metrics::stageName(Stage stage) {
+    static const char* names[STAGE_COUNT] = {
+        "url_decode", "tokenize", "cache_lookup", "retrieval",
+        "snippet", "serialize", "suggest", "request"
+    };
+    return names[stage];
+}
+
+const char* Metrics::endpointName(Endpoint endpoint) {
+    static const char* names[ENDPOINT_COUNT] = {"search", "msearch", "suggest"};
+    return names[endpoint];
+}
+
+void Metrics::appendHeader(string& out, const char* name, const char* type, const char* help) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+void Metrics::appendSample(string& out, const char* name, const string& labels, double value) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.9g", value);
+    out += name;
+    if (!labels.empty()) {
+        out += '{';
+        out += labels;
+        out += '}';
+    }
+    out += ' ';
+    out += buf;
+    out += '\n';
+}
+
+void Metrics::render(string& out) const {
+    appendHeader(out, "search_requests_total", "counter", "Requests received per endpoint.");
+    for (int e = 0; e < ENDPOINT_COUNT; ++e) {
+        appendSample(out, "search_requests_total",
+                     string("endpoint=\"") + endpointName((Endpoint)e) + "\"",
+                     (double)_requests[e].load(std::memory_order_relaxed));
+    }
+
+    appendHeader(out, "search_qps", "gauge", "Average requests per second over the last 10 seconds.");
+    for (int e = 0; e < ENDPOINT_COUNT; ++e) {
+        appendSample(out, "search_qps", string("endpoint=\"") + endpointName((Endpoint)e) + "\"",
+                     qps((Endpoint)e));
+    }
+
+    appendHeader(out, "search_errors_total", "counter", "Error responses by status class.");
+    appendSample(out, "search_errors_total", "code=\"4xx\"",
+                 (double)_clientErrors.load(std::memory_order_relaxed));
+    appendSample(out, "search_errors_total", "code=\"5xx\"",
+                 (double)_serverErrors.load(std::memory_order_relaxed));
+
+    // 导出时把细粒度桶折算到固定边界（按桶上界归入，边界附近略有低估）
+    static const double bounds[] = {
+        0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005,
+        0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5
+    };
+    static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+    vector<HistogramSnapshot> snaps;
+    snaps.reserve(STAGE_COUNT);
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        snaps.push_back(snapshot((Stage)s));
+    }
+
+    appendHeader(out, "search_stage_duration_seconds", "histogram", "Latency of each request processing stage.");
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        const HistogramSnapshot& snap = snaps[s];
+        string stage = string("stage=\"") + stageName((Stage)s) + "\"";
+
+        size_t bucket = 0;
+        uint64_t cumulative = 0;
+        for (double bound : bounds) {
+            uint64_t limitUs = (uint64_t)(bound * 1e6);
+            while (bucket < snap.counts.size() && LatencyHistogram::bucketUpper((int)bucket) <= limitUs) {
+                cumulative += snap.counts[bucket++];
+            }
+            char le[32];
+            snprintf(le, sizeof(le), "%g", bound);
+            appendSample(out, "search_stage_duration_seconds_bucket",
+                         stage + ",le=\"" + le + "\"", (double)cumulative);
+        }
+        appendSample(out, "search_stage_duration_seconds_bucket", stage + ",le=\"+Inf\"", (double)snap.total);
+        appendSample(out, "search_stage_duration_seconds_sum", stage, snap.sumUs / 1e6);
+        appendSample(out, "search_stage_duration_seconds_count", stage, (double)snap.total);
+    }
+
+    appendHeader(out, "search_stage_duration_quantile_seconds", "gauge",
+                 "Latency quantiles of each stage since start, from the full-resolution histogram.");
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        for (double q : quantiles) {
+            char label[96];
+            snprintf(label, sizeof(label), "stage=\"%s\",quantile=\"%g\"", stageName((Stage)s), q);
+            appendSample(out, "search_stage_duration_quantile_seconds", label,
+                         snaps[s].quantile(q) / 1e6);
+        }
+    }
+}
+
+int64_t StageTimer::stop() {
+    int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - _start).count();
+    if (!_stopped) {
+        _stopped = true;
+        Metrics::getInstance()->record(_stage, us);
+    }
+    return us;
+}
@@ -1,239 +1,317 @@
-#include "PageLib.h"
-#include "WebPage.h"
-#include "Logger.h"
-#include <fstream>
-#include <sstream>
-#include <algorithm>
-#include <dirent.h>
-#include <sys/stat.h>
-
-using std::ifstream;
-using std::ofstream;
-using std::stringstream;
-using std::make_shared;
-// 最大文档数量限制（防止内存溢出）
-static const size_t MAX_DOCS = 300000;  // 30万篇上限  可修改
-
-PageLib::PageLib(const string& dataPath, SplitTool* splitTool)
-    : _dataPath(dataPath)
-    , _splitTool(splitTool) {
-}
-
-void PageLib::load() {
-    // 遍历数据目录，加载所有文件
-    DIR* dir = opendir(_dataPath.c_str());
-    if (!dir) {
-        LOG_ERROR("Cannot open data directory: " + _dataPath);
-        return;
-    }
-
-    struct dirent* entry;
-    while ((entry = readdir(dir)) != nullptr) {
-        string filename = entry->d_name;
-        if (filename == "." || filename == "..") {
-            continue;
-        }
-
-        string filepath = _dataPath + "/" + filename;
-        struct stat st;
-        // 支持 .xml 和 .dat 文件格式
-        if (stat(filepath.c_str(), &st) == 0 && S_ISREG(st.st_mode) &&
-            (filename.find(".xml") != string::npos || filename.find(".dat") != string::npos)) {
-            parseFile(filepath);
-             if (_pages.size() >= MAX_DOCS) {
-                  break;
-              }
-        }
-    }
-    closedir(dir);
-
-    LOG_INFO("Loaded " + std::to_string(_pages.size()) + " pages");
-}
-
-void PageLib::parseFile(const string& filePath) {
-    ifstream ifs(filePath);
-    if (!ifs) {
-        LOG_WARN("Cannot open file: " + filePath);
-        return;
-    }
-
-    // 流式读取：分块读取文件，边读边解析，避免一次性加载整个文件
-    const size_t CHUNK_SIZE = 1024 * 1024; // 1MB 分块
-    char* chunk = new char[CHUNK_SIZE];
-    string buffer;
-    buffer.reserve(CHUNK_SIZE * 2);
-
-    const string docStart = "<doc>";
-    const string docEnd = "</doc>";
-    size_t processedCount = 0;
-    size_t initialSize = _pages.size();
-
-    while (ifs.read(chunk, CHUNK_SIZE) || ifs.gcount() > 0) {
-        buffer.append(chunk, ifs.gcount());
-
-        // 处理所有完整的 <doc>...</doc> 块
-        size_t searchStart = 0;
-        while (true) {
-            size_t startPos = buffer.find(docStart, searchStart);
-            if (startPos == string::npos) {
-                // 没有找到 <doc>，清理前面的内容
-                buffer.clear();
-                break;
-            }
-
-            size_t endPos = buffer.find(docEnd, startPos);
-            if (endPos == string::npos) {
-                // 有 <doc> 但没有 </doc>，保留从 startPos 开始的内容
-                if (startPos > 0) {
-                    buffer = buffer.substr(startPos);
-                }
-                break;
-            }
-
-            // 提取并处理完整的文档
-            string doc = buffer.substr(startPos, endPos - startPos + docEnd.length());
-            auto page = make_shared<WebPage>(doc, _splitTool);
-            _pages.push_back(page);
-            if (_pages.size() >= MAX_DOCS) {
-                  LOG_INFO("Reached max document limit: " + std::to_string(MAX_DOCS));
-                  delete[] chunk;
-                  return;
-              }
-            processedCount++;
-            if (processedCount % 10000 == 0) {
-                LOG_INFO("Loaded " + std::to_string(processedCount) + " documents...");
-            }
-
-            searchStart = endPos + docEnd.length();
-        }
-
-        // 清理已处理的内容，保留未处理的部分
-        if (searchStart > 0 && searchStart < buffer.length()) {
-            buffer = buffer.substr(searchStart);
-        } else if (searchStart >= buffer.length()) {
-            buffer.clear();
-        }
-    }
-
-    delete[] chunk;
-
-    // 如果没有解析到任何文档，尝试把整个文件当作一个文档（兼容旧格式）
-    if (_pages.size() == initialSize) {
-        ifs.clear();
-        ifs.seekg(0);
-        stringstream ss;
-        ss << ifs.rdbuf();
-        string content = ss.str();
-        if (!content.empty()) {
-            auto page = make_shared<WebPage>(content, _splitTool);
-            _pages.push_back(page);
-        }
-    }
-}
-
-void PageLib::store(const string& outputPath) {
-    ofstream ofs(outputPath);
-    if (!ofs) {
-        LOG_ERROR("Cannot create output file: " + outputPath);
-        return;
-    }
-
-    for (const auto& page : _pages) {
-        ofs << "<doc>\n";
-        ofs << "<docid>" << page->getDocId() << "</docid>\n";
-        ofs << "<title>" << page->getTitle() << "</title>\n";
-        ofs << "<url>" << page->getUrl() << "</url>\n";
-        ofs << "<content>" << page->getContent() << "</content>\n";
-        ofs << "</doc>\n\n";
-    }
-
-    LOG_INFO("Stored " + std::to_string(_pages.size()) + " pages to " + outputPath);
-}
-
-void PageLib::storeSeparated(const string& metaPath, const string& contentPath) {
-    // 1. 写入内容文件（二进制）
-    ofstream contentOfs(contentPath, std::ios::binary);
-    if (!contentOfs) {
-        LOG_ERROR("Cannot create content file: " + contentPath);
-        return;
-    }
-
-    // 2. 写入元数据文件
-    ofstream metaOfs(metaPath);
-    if (!metaOfs) {
-        LOG_ERROR("Cannot create meta file: " + metaPath);
-        return;
-    }
-
-    metaOfs << "#FORMAT docId|title|url|offset|length\n";
-
-    size_t currentOffset = 0;
-for (const auto& page : _pages) {
-          string content = page->getContent();
-          size_t contentLen = content.length();
-
-          // 写入内容
-          contentOfs.write(content.c_str(), contentLen);
-
-          // 清理标题和URL中的特殊字符（换行符和分隔符）
-          string title = page->getTitle();
-          string url = page->getUrl();
-          std::replace(title.begin(), title.end(), '\n', ' ');
-          std::replace(title.begin(), title.end(), '\r', ' ');
-          std::replace(title.begin(), title.end(), '|', ' ');
-          std::replace(url.begin(), url.end(), '\n', ' ');
-          std::replace(url.begin(), url.end(), '\r', ' ');
-          std::replace(url.begin(), url.end(), '|', ' ');
-
-          // 写入元数据（使用 | 分隔，避免标题中的空格问题）
-          metaOfs << page->getDocId() << "|"
-                  << title << "|"
-                  << url << "|"
-                  << currentOffset << "|"
-                  << contentLen << "\n";
-
-          currentOffset += contentLen;
-      }
-
-    LOG_INFO("Stored " + std::to_string(_pages.size()) + " pages (separated format)");
-    LOG_INFO("  Meta: " + metaPath);
-    LOG_INFO("  Content: " + contentPath + " (" + std::to_string(currentOffset) + " bytes)");
-}
-
-unordered_map<int, WebPageMeta> PageLib::loadMeta(const string& metaPath) {
-    unordered_map<int, WebPageMeta> result;
-
-    ifstream ifs(metaPath);
-    if (!ifs) {
-        LOG_ERROR("Cannot open meta file: " + metaPath);
-        return result;
-    }
-
-    string line;
-    while (std::getline(ifs, line)) {
-        if (line.empty() || line[0] == '#') continue;
-
-        // 解析：docId|title|url|offset|length
-        size_t p1 = line.find('|');
-        size_t p2 = line.find('|', p1 + 1);
-        size_t p3 = line.find('|', p2 + 1);
-        size_t p4 = line.find('|', p3 + 1);
-
-        if (p1 == string::npos || p2 == string::npos ||
-            p3 == string::npos || p4 == string::npos) {
-            continue;
-        }
-
-        WebPageMeta meta;
-        meta.docId = std::stoi(line.substr(0, p1));
-        meta.title = line.substr(p1 + 1, p2 - p1 - 1);
-        meta.url = line.substr(p2 + 1, p3 - p2 - 1);
-        meta.contentOffset = std::stoull(line.substr(p3 + 1, p4 - p3 - 1));
-        meta.contentLength = std::stoull(line.substr(p4 + 1));
-
-        result[meta.docId] = meta;
-    }
-
-    LOG_INFO("Loaded " + std::to_string(result.size()) + " page metadata entries");
-    return result;
-}
+#include "PageLib.h"
+#include "WebPage.h"
+#include "JsonWriter.h"
+#include "BuildProfiler.h"
+#include "Logger.h"
+#include <fstream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using std::ifstream;
+using std::ofstream;
+using std::make_shared;
+// 最大文档数量限制（防止内存溢出）
+static const size_t MAX_DOCS = 300000;  // 30万篇上限  可修改
+
+PageLib::PageLib(const string& dataPath, SplitTool* splitTool)
+    : _dataPath(dataPath)
+    , _splitTool(splitTool) {
+}
+
+void PageLib::load() {
+    // 遍历数据目录，加载所有文件
+    DIR* dir = opendir(_dataPath.c_str());
+    if (!dir) {
+        LOG_ERROR("Cannot open data directory: " + _dataPath);
+        return;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        string filename = entry->d_name;
+        if (filename == "." || filename == "..") {
+            continue;
+        }
+
+        string filepath = _dataPath + "/" + filename;
+        struct stat st;
+        // 支持 .xml 和 .dat 文件格式
+        if (stat(filepath.c_str(), &st) == 0 && S_ISREG(st.st_mode) &&
+            (filename.find(".xml") != string::npos || filename.find(".dat") != string::npos)) {
+            parseFile(filepath);
+             if (_pages.size() >= MAX_DOCS) {
+                  break;
+              }
+        }
+    }
+    closedir(dir);
+
+    LOG_INFO("Loaded " + std::to_string(_pages.size()) + " pages");
+}
+
+// 在 data[from, end) 中查找 needle（glibc memmem 对短模式做了向量化）
+static size_t findIn(string_view data, size_t from, string_view needle) {
+    if (from >= data.size()) {
+        return string_view::npos;
+    }
+    const void* found = memmem(data.data() + from, data.size() - from, needle.data(), needle.size());
+    return found ? static_cast<const char*>(found) - data.data() : string_view::npos;
+}
+
+void PageLib::parseFile(const string& filePath) {
+    int fd = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_WARN("Cannot open file: " + filePath);
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return;
+    }
+    size_t size = (size_t)st.st_size;
+
+    // 整个文件映射为只读视图，<doc> 块以 string_view 直接交给 WebPage 解析，不再经过分块缓冲区的拷贝
+    // 映射失败（如特殊文件系统）时退回一次性读入内存，后续解析相同
+    // 映射时不预读：页面随解析顺序缺页调入，读盘与抽取交错进行，这部分耗时计入 extract（见 BuildProfiler::setMappedInput）
+    string fallback;
+    string_view data;
+    void* addr;
+    {
+        PhaseTimer timer(PHASE_READ);
+        addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            madvise(addr, size, MADV_SEQUENTIAL);
+            BuildProfiler::getInstance()->setMappedInput();
+            data = string_view(static_cast<const char*>(addr), size);
+        } else {
+            LOG_WARN("mmap corpus file failed, reading into memory: " + string(strerror(errno)));
+            fallback.resize(size);
+            size_t done = 0;
+            while (done < size) {
+                ssize_t n = pread(fd, &fallback[done], size - done, done);
+                if (n <= 0) {
+                    break;
+                }
+                done += n;
+            }
+            fallback.resize(done);
+            data = fallback;
+        }
+    }
+    ::close(fd);
+    BuildProfiler::getInstance()->addInputBytes(data.size());
+
+    parseBuffer(data);
+
+    if (addr != MAP_FAILED) {
+        munmap(addr, size);
+    }
+}
+
+void PageLib::parseBuffer(string_view data) {
+    const string_view docStart = "<doc>";
+    const string_view docEnd = "</doc>";
+    BuildProfiler* profiler = BuildProfiler::getInstance();
+    size_t processedCount = 0;
+    size_t initialSize = _pages.size();
+
+    // 处理所有完整的 <doc>...</doc> 块
+    size_t searchStart = 0;
+    while (true) {
+        PhaseTimer splitTimer(PHASE_EXTRACT);
+        size_t startPos = findIn(data, searchStart, docStart);
+        if (startPos == string_view::npos) {
+            break;
+        }
+        size_t endPos = findIn(data, startPos, docEnd);
+        if (endPos == string_view::npos) {
+            break;
+        }
+        string_view doc = data.substr(startPos, endPos - startPos + docEnd.size());
+        splitTimer.stop();
+
+        // 抽取与分词由 WebPage 内部分别计时
+        _pages.push_back(make_shared<WebPage>(doc, _splitTool));
+        profiler->addInputDocs(1);
+        if (_pages.size() >= MAX_DOCS) {
+            LOG_INFO("Reached max document limit: " + std::to_string(MAX_DOCS));
+            return;
+        }
+        processedCount++;
+        if (processedCount % 10000 == 0) {
+            LOG_INFO("Loaded " + std::to_string(processedCount) + " documents...");
+        }
+
+        searchStart = endPos + docEnd.size();
+    }
+
+    // 如果没有解析到任何文档，把整个文件当作一个文档（兼容旧格式）
+    if (_pages.size() == initialSize && !data.empty()) {
+        _pages.push_back(make_shared<WebPage>(data, _splitTool));
+        profiler->addInputDocs(1);
+    }
+}
+
+void PageLib::store(const string& outputPath) {
+    ofstream ofs(outputPath);
+    if (!ofs) {
+        LOG_ERROR("Cannot create output file: " + outputPath);
+        return;
+    }
+
+    for (const auto& page : _pages) {
+        ofs << "<doc>\n";
+        ofs << "<docid>" << page->getDocId() << "</docid>\n";
+        ofs << "<title>" << page->getTitle() << "</title>\n";
+        ofs << "<url>" << page->getUrl() << "</url>\n";
+        ofs << "<content>" << page->getContent() << "</content>\n";
+        ofs << "</doc>\n\n";
+    }
+
+    LOG_INFO("Stored " + std::to_string(_pages.size()) + " pages to " + outputPath);
+}
+
+void PageLib::storeSeparated(const string& metaPath, const string& contentPath,
+                             const string& segPath) {
+    // 1. 写入内容文件（二进制）
+    ofstream contentOfs(contentPath, std::ios::binary);
+    if (!contentOfs) {
+        LOG_ERROR("Cannot create content file: " + contentPath);
+        return;
+    }
+
+    // 2. 写入元数据文件
+    ofstream metaOfs(metaPath);
+    if (!metaOfs) {
+        LOG_ERROR("Cannot create meta file: " + metaPath);
+        return;
+    }
+
+    // 3. 分句索引文件（二进制 uint32 数组，每篇文档的句子结束偏移依次排列）
+    ofstream segOfs;
+    if (!segPath.empty()) {
+        segOfs.open(segPath, std::ios::binary);
+        if (!segOfs) {
+            LOG_ERROR("Cannot create sentence index file: " + segPath);
+            return;
+        }
+        metaOfs << "#FORMAT v2 docId|titleJson|urlJson|offset|length|segOffset|segCount\n";
+    } else {
+        metaOfs << "#FORMAT v2 docId|titleJson|urlJson|offset|length\n";
+    }
+
+    size_t currentOffset = 0;
+    size_t segOffset = 0;
+for (const auto& page : _pages) {
+          string content = page->getContent();
+          size_t contentLen = content.length();
+
+          // 写入内容
+          contentOfs.write(content.c_str(), contentLen);
+
+          // 清理标题和URL中的特殊字符（换行符和分隔符）
+          string title = page->getTitle();
+          string url = page->getUrl();
+          std::replace(title.begin(), title.end(), '\n', ' ');
+          std::replace(title.begin(), title.end(), '\r', ' ');
+          std::replace(title.begin(), title.end(), '|', ' ');
+          std::replace(url.begin(), url.end(), '\n', ' ');
+          std::replace(url.begin(), url.end(), '\r', ' ');
+          std::replace(url.begin(), url.end(), '|', ' ');
+
+          // 标题和 URL 建库时校验 UTF-8 并做 JSON 转义，查询时无需再处理
+          string titleJson, urlJson;
+          JsonWriter::escape(titleJson, title);
+          JsonWriter::escape(urlJson, url);
+
+          // 写入元数据（使用 | 分隔，避免标题中的空格问题）
+          metaOfs << page->getDocId() << "|"
+                  << titleJson << "|"
+                  << urlJson << "|"
+                  << currentOffset << "|"
+                  << contentLen;
+
+          if (segOfs.is_open()) {
+              const auto& ends = page->getSentenceEnds();
+              segOfs.write(reinterpret_cast<const char*>(ends.data()),
+                           ends.size() * sizeof(uint32_t));
+              metaOfs << "|" << segOffset << "|" << ends.size();
+              segOffset += ends.size();
+          }
+          metaOfs << "\n";
+
+          currentOffset += contentLen;
+      }
+
+    LOG_INFO("Stored " + std::to_string(_pages.size()) + " pages (separated format)");
+    LOG_INFO("  Meta: " + metaPath);
+    LOG_INFO("  Content: " + contentPath + " (" + std::to_string(currentOffset) + " bytes)");
+    if (segOfs.is_open()) {
+        LOG_INFO("  Sentence index: " + segPath + " (" + std::to_string(segOffset) + " boundaries)");
+    }
+}
+
+unordered_map<int, WebPageMeta> PageLib::loadMeta(const string& metaPath) {
+    unordered_map<int, WebPageMeta> result;
+
+    ifstream ifs(metaPath);
+    if (!ifs) {
+        LOG_ERROR("Cannot open meta file: " + metaPath);
+        return result;
+    }
+
+    // v2 格式的标题 / URL 已在建库时转义；旧格式在加载时转义一次
+    bool preEscaped = false;
+
+    string line;
+    while (std::getline(ifs, line)) {
+        if (line.empty()) continue;
+        if (line[0] == '#') {
+            if (line.compare(0, 11, "#FORMAT v2 ") == 0) {
+                preEscaped = true;
+            }
+            continue;
+        }
+
+        // 解析：docId|title|url|offset|length[|segOffset|segCount]
+        size_t p1 = line.find('|');
+        size_t p2 = line.find('|', p1 + 1);
+        size_t p3 = line.find('|', p2 + 1);
+        size_t p4 = line.find('|', p3 + 1);
+
+        if (p1 == string::npos || p2 == string::npos ||
+            p3 == string::npos || p4 == string::npos) {
+            continue;
+        }
+        size_t p5 = line.find('|', p4 + 1);
+        size_t p6 = (p5 == string::npos) ? string::npos : line.find('|', p5 + 1);
+
+        WebPageMeta meta;
+        meta.docId = std::stoi(line.substr(0, p1));
+        if (preEscaped) {
+            meta.titleJson = line.substr(p1 + 1, p2 - p1 - 1);
+            meta.urlJson = line.substr(p2 + 1, p3 - p2 - 1);
+        } else {
+            JsonWriter::escape(meta.titleJson, string_view(line).substr(p1 + 1, p2 - p1 - 1));
+            JsonWriter::escape(meta.urlJson, string_view(line).substr(p2 + 1, p3 - p2 - 1));
+        }
+        meta.contentOffset = std::stoull(line.substr(p3 + 1, p4 - p3 - 1));
+        meta.contentLength = std::stoull(line.substr(p4 + 1, p5 - p4 - 1));
+        if (p6 != string::npos) {
+            meta.segOffset = std::stoull(line.substr(p5 + 1, p6 - p5 - 1));
+            meta.segCount = std::stoul(line.substr(p6 + 1));
+        }
+
+        result[meta.docId] = meta;
+    }
+
+    LOG_INFO("Loaded " + std::to_string(result.size()) + " page metadata entries");
+    return result;
+}
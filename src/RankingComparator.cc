@@ -0,0 +1,226 @@
+#include "RankingComparator.h"
+#include "InvertIndex.h"
+#include "JsonWriter.h"
+#include "Logger.h"
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+using std::unordered_map;
+
+RankingComparator::RankingComparator(InvertIndex* a, const string& labelA, InvertIndex* b, const string& labelB)
+    : _a(a)
+    , _b(b)
+    , _labelA(labelA)
+    , _labelB(labelB) {
+}
+
+QueryDiff RankingComparator::diff(const vector<pair<int, double>>& a, const vector<pair<int, double>>& b) {
+    QueryDiff result;
+    if (a.empty()) {
+        result.identical = b.empty();
+        result.overlap = result.ndcg = b.empty() ? 1 : 0;
+        return result;
+    }
+
+    // A 中排第 r 位的文档增益为 |A| - r，A 自身的排列即理想排列
+    unordered_map<int, pair<size_t, double>> rankA;   // docId -> (名次, 得分)
+    for (size_t i = 0; i < a.size(); ++i) {
+        rankA[a[i].first] = {i, a[i].second};
+    }
+
+    double dcg = 0, idcg = 0;
+    size_t common = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        idcg += (double)(a.size() - i) / std::log2(i + 2.0);
+    }
+    for (size_t i = 0; i < b.size(); ++i) {
+        auto it = rankA.find(b[i].first);
+        if (it == rankA.end()) {
+            continue;
+        }
+        common++;
+        dcg += (double)(a.size() - it->second.first) / std::log2(i + 2.0);
+        result.maxScoreDelta = std::max(result.maxScoreDelta, std::fabs(b[i].second - it->second.second));
+    }
+
+    result.overlap = (double)common / a.size();
+    result.ndcg = dcg / idcg;
+    result.identical = a.size() == b.size() && common == a.size();
+    for (size_t i = 0; result.identical && i < a.size(); ++i) {
+        result.identical = a[i].first == b[i].first;
+    }
+    return result;
+}
+
+static HistogramSnapshot snapshotOf(const LatencyHistogram& hist) {
+    HistogramSnapshot snap;
+    snap.counts.assign(LatencyHistogram::BUCKET_COUNT, 0);
+    for (int i = 0; i < LatencyHistogram::BUCKET_COUNT; ++i) {
+        snap.counts[i] = hist.counts[i].load(std::memory_order_relaxed);
+        snap.total += snap.counts[i];
+    }
+    snap.sumUs = hist.sumUs.load(std::memory_order_relaxed);
+    return snap;
+}
+
+ComparisonReport RankingComparator::compare(const vector<string>& queries, const vector<vector<string>>& tokenized,
+                                            int topK, int warmupRounds, size_t worstCount) {
+    using std::chrono::steady_clock;
+
+    ComparisonReport report;
+    report.labelA = _labelA;
+    report.labelB = _labelB;
+    report.topK = topK;
+
+    for (int round = 0; round < warmupRounds; ++round) {
+        for (const auto& words : tokenized) {
+            _a->search(words, topK);
+            _b->search(words, topK);
+        }
+    }
+
+    // 两个引擎紧挨着执行同一查询，机器负载的波动对双方影响相同；
+    // 后执行的一方会遇到已在 CPU 缓存中的倒排表与文档长度，因此奇数号查询先执行 B，双方各先执行一半
+    LatencyHistogram histA, histB;
+    int64_t totalNsA = 0, totalNsB = 0;
+    vector<QueryDiff> diffs;
+    diffs.reserve(tokenized.size());
+    auto timedSearch = [&tokenized, topK](InvertIndex* index, size_t q, int64_t& ns) {
+        auto start = steady_clock::now();
+        auto result = index->search(tokenized[q], topK);
+        ns = std::chrono::duration_cast<std::chrono::nanoseconds>(steady_clock::now() - start).count();
+        return result;
+    };
+    for (size_t q = 0; q < tokenized.size(); ++q) {
+        int64_t nsA = 0, nsB = 0;
+        vector<pair<int, double>> resultA, resultB;
+        if (q % 2 == 0) {
+            resultA = timedSearch(_a, q, nsA);
+            resultB = timedSearch(_b, q, nsB);
+        } else {
+            resultB = timedSearch(_b, q, nsB);
+            resultA = timedSearch(_a, q, nsA);
+        }
+
+        totalNsA += nsA;
+        totalNsB += nsB;
+        histA.record(nsA / 1000);
+        histB.record(nsB / 1000);
+
+        QueryDiff d = diff(resultA, resultB);
+        d.query = q < queries.size() ? queries[q] : "";
+        if (resultA.empty() && resultB.empty()) {
+            report.emptyBoth++;
+        }
+        diffs.push_back(std::move(d));
+    }
+
+    report.queries = diffs.size();
+    for (const auto& d : diffs) {
+        report.identical += d.identical ? 1 : 0;
+        report.meanOverlap += d.overlap;
+        report.minOverlap = std::min(report.minOverlap, d.overlap);
+        report.meanNdcg += d.ndcg;
+        report.minNdcg = std::min(report.minNdcg, d.ndcg);
+        report.meanScoreDelta += d.maxScoreDelta;
+        report.maxScoreDelta = std::max(report.maxScoreDelta, d.maxScoreDelta);
+    }
+    if (report.queries > 0) {
+        report.meanOverlap /= report.queries;
+        report.meanNdcg /= report.queries;
+        report.meanScoreDelta /= report.queries;
+    }
+    report.latencyA = snapshotOf(histA);
+    report.latencyB = snapshotOf(histB);
+    report.speedup = totalNsB > 0 ? (double)totalNsA / totalNsB : 0;
+
+    // 只保留有差异的查询，NDCG 相同时按得分差排
+    vector<QueryDiff> changed;
+    for (auto& d : diffs) {
+        if (!d.identical || d.maxScoreDelta > 0) {
+            changed.push_back(std::move(d));
+        }
+    }
+    size_t n = std::min(worstCount, changed.size());
+    std::partial_sort(changed.begin(), changed.begin() + n, changed.end(),
+                      [](const QueryDiff& x, const QueryDiff& y) {
+                          return x.ndcg != y.ndcg ? x.ndcg < y.ndcg : x.maxScoreDelta > y.maxScoreDelta;
+                      });
+    changed.resize(n);
+    report.worst = std::move(changed);
+    return report;
+}
+
+void ComparisonReport::log() const {
+    char line[256];
+    LOG_INFO("=== Ranking Comparison: " + labelA + " (baseline) vs " + labelB + " ===");
+    snprintf(line, sizeof(line), "Queries: %zu, identical top-%d: %zu (%.2f%%), both empty: %zu",
+             queries, topK, identical, queries ? identical * 100.0 / queries : 0, emptyBoth);
+    LOG_INFO(line);
+    snprintf(line, sizeof(line), "Overlap@%d: mean %.4f, min %.4f; NDCG@%d: mean %.4f, min %.4f",
+             topK, meanOverlap, minOverlap, topK, meanNdcg, minNdcg);
+    LOG_INFO(line);
+    snprintf(line, sizeof(line), "Score delta on common docs: mean %.3g, max %.3g", meanScoreDelta, maxScoreDelta);
+    LOG_INFO(line);
+    snprintf(line, sizeof(line), "Latency us: %s p50 %llu p99 %llu mean %.1f | %s p50 %llu p99 %llu mean %.1f | speedup %.2fx",
+             labelA.c_str(), (unsigned long long)latencyA.quantile(0.5), (unsigned long long)latencyA.quantile(0.99),
+             latencyA.total ? (double)latencyA.sumUs / latencyA.total : 0.0,
+             labelB.c_str(), (unsigned long long)latencyB.quantile(0.5), (unsigned long long)latencyB.quantile(0.99),
+             latencyB.total ? (double)latencyB.sumUs / latencyB.total : 0.0, speedup);
+    LOG_INFO(line);
+    for (const auto& d : worst) {
+        snprintf(line, sizeof(line), "  overlap %.2f ndcg %.4f score delta %.3g: ", d.overlap, d.ndcg, d.maxScoreDelta);
+        LOG_INFO(line + d.query);
+    }
+}
+
+void ComparisonReport::toJson(string& out) const {
+    JsonWriter writer(out);
+    writer.beginObject();
+    writer.key("baseline").value(labelA);
+    writer.key("candidate").value(labelB);
+    writer.key("top_k").value(topK);
+    writer.key("queries").value(queries);
+    writer.key("identical").value(identical);
+    writer.key("both_empty").value(emptyBoth);
+    writer.key("overlap").beginObject();
+    writer.key("mean").value(meanOverlap);
+    writer.key("min").value(minOverlap);
+    writer.endObject();
+    writer.key("ndcg").beginObject();
+    writer.key("mean").value(meanNdcg);
+    writer.key("min").value(minNdcg);
+    writer.endObject();
+    writer.key("score_delta").beginObject();
+    writer.key("mean").value(meanScoreDelta);
+    writer.key("max").value(maxScoreDelta);
+    writer.endObject();
+
+    auto writeLatency = [&writer](const string& name, const HistogramSnapshot& snap) {
+        writer.key(name).beginObject();
+        writer.key("p50").value((size_t)snap.quantile(0.5));
+        writer.key("p99").value((size_t)snap.quantile(0.99));
+        writer.key("mean").value(snap.total ? (double)snap.sumUs / snap.total : 0.0);
+        writer.endObject();
+    };
+    writer.key("latency_us").beginObject();
+    writeLatency("baseline", latencyA);
+    writeLatency("candidate", latencyB);
+    writer.endObject();
+    writer.key("speedup").value(speedup);
+
+    writer.key("worst").beginArray();
+    for (const auto& d : worst) {
+        writer.beginObject();
+        writer.key("query").value(d.query);
+        writer.key("overlap").value(d.overlap);
+        writer.key("ndcg").value(d.ndcg);
+        writer.key("max_score_delta").value(d.maxScoreDelta);
+        writer.endObject();
+    }
+    writer.endArray();
+    writer.endObject();
+}
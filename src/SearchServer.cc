@@ -1,14 +1,42 @@
 #include "SearchServer.h"
 #include "InvertIndex.h"
+#include "TermCache.h"
 #include "SplitTool.h"
 #include "WebPage.h"
 #include "DictProducer.h"
 #include "KeywordRecommender.h"
+#include "CacheWarmer.h"
+#include "AdmissionController.h"
+#include "SlowQueryLog.h"
+#include "JsonWriter.h"
+#include "Metrics.h"
+#include "MemoryUsage.h"
 #include "Logger.h"
 #include "wfrest/HttpServer.h"
 #include "wfrest/json.hpp"
+#include "workflow/WFTaskFactory.h"
+#include "workflow/Workflow.h"
+#include "workflow/WFGlobal.h"
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <unordered_set>
+
+// 请求截止时间：请求头 X-Deadline-Ms 优先，否则取配置默认值
+static int requestDeadlineMs(const wfrest::HttpReq* req, int defaultMs) {
+    string header = req->header("X-Deadline-Ms");
+    if (!header.empty()) {
+        int value = std::atoi(header.c_str());
+        if (value > 0) {
+            return value;
+        }
+    }
+    return defaultMs;
+}
 
 // URL 解码函数
 static string urlDecode(const string& encoded) {
@@ -34,41 +62,24 @@ static string urlDecode(const string& encoded) {
     return decoded;
 }
 
-// 清理无效 UTF-8 字节，防止 JSON 序列化崩溃
-static string cleanUtf8(const string& str) {
-    string result;
-    result.reserve(str.size());
-    for (size_t i = 0; i < str.size(); ) {
-        unsigned char c = str[i];
-        size_t len = 1;
-        if ((c & 0x80) == 0) len = 1;           // ASCII
-        else if ((c & 0xE0) == 0xC0) len = 2;   // 2字节UTF-8
-        else if ((c & 0xF0) == 0xE0) len = 3;   // 3字节UTF-8
-        else if ((c & 0xF8) == 0xF0) len = 4;   // 4字节UTF-8
-        else { i++; continue; }                  // 无效起始字节，跳过
-
-        // 验证后续字节
-        bool valid = true;
-        if (i + len > str.size()) valid = false;
-        for (size_t j = 1; valid && j < len; j++) {
-            if ((str[i + j] & 0xC0) != 0x80) valid = false;
-        }
-
-        if (valid) {
-            result.append(str, i, len);
-            i += len;
-        } else {
-            i++;
-        }
-    }
-    return result;
-}
-
 using wfrest::HttpServer;
 using wfrest::HttpReq;
 using wfrest::HttpResp;
 using nlohmann::json;
 
+// 错误响应：{"error": message}，并计入错误统计
+static void replyError(wfrest::HttpResp* resp, int status, const string& message) {
+    json error;
+    error["error"] = message;
+    resp->set_status(status);
+    resp->String(error.dump());
+    Metrics::getInstance()->countError(status);
+}
+
+// 计算队列名：搜索与推荐分队列，workflow 在队列间轮转调度，慢推荐不会饿死搜索
+static const string SEARCH_QUEUE = "search_compute";
+static const string SUGGEST_QUEUE = "suggest_compute";
+
 SearchServer::SearchServer(const string& ip, int port,
                            shared_ptr<InvertIndex> index,
                            SplitTool* splitTool)
@@ -79,15 +90,22 @@ SearchServer::SearchServer(const string& ip, int port,
     , _cache(std::make_shared<SearchCache>(1000)) {
 }
 
+SearchServer::~SearchServer() = default;
+
 void SearchServer::setPageLib(const map<int, shared_ptr<WebPage>>& pageLib) {
     _pageLib = pageLib;
     _useLiteMode = false;
 }
 
 void SearchServer::setPageLibLite(const unordered_map<int, WebPageMeta>& pageMeta,
-                                   const string& contentFilePath) {
+                                   const string& contentFilePath,
+                                   size_t mmapLimit,
+                                   const string& segFilePath) {
     _pageMetaLib = pageMeta;
-    _contentStore = std::make_shared<ContentStore>(contentFilePath);
+    _contentStore = std::make_shared<ContentStore>(contentFilePath, mmapLimit);
+    if (!segFilePath.empty()) {
+        _contentStore->loadSegments(segFilePath);
+    }
     _useLiteMode = true;
 }
 
@@ -103,11 +121,98 @@ void SearchServer::setCacheCapacity(size_t capacity) {
     _cache = std::make_shared<SearchCache>(capacity);
 }
 
+void SearchServer::setRankedListCache(size_t capacity, int depth) {
+    if (capacity == 0) {
+        _rankedCache.reset();
+    } else {
+        _rankedCache = std::make_shared<RankedListCache>(capacity);
+    }
+    _rankedDepth = std::max(depth, SearchPage::DEFAULT_SIZE);
+}
+
+void SearchServer::setSnippetCacheCapacity(size_t capacity) {
+    if (capacity == 0) {
+        _snippetCache.reset();
+    } else {
+        _snippetCache = std::make_shared<SnippetCache>(capacity);
+    }
+}
+
+void SearchServer::setAsyncSnippet(bool enabled, int deadlineMs) {
+    _asyncSnippet = enabled;
+    _snippetDeadlineMs = std::max(deadlineMs, 1);
+}
+
+void SearchServer::setCacheWarmup(const string& snapshotPath, const string& queryLogPath,
+                                  int snapshotInterval, size_t warmupQueries, int warmupThreads) {
+    _warmer.reset(new CacheWarmer(snapshotPath, queryLogPath));
+    _snapshotInterval = std::max(snapshotInterval, 1);
+    _warmupQueries = warmupQueries;
+    _warmupThreads = std::max(warmupThreads, 1);
+}
+
+void SearchServer::setAdmissionControl(int maxConcurrent, int maxQueue, int defaultDeadlineMs) {
+    _admission.reset(new AdmissionController(maxConcurrent, maxQueue));
+    _requestDeadlineMs = std::max(defaultDeadlineMs, 1);
+}
+
+void SearchServer::setMaxBatchQueries(size_t maxQueries) {
+    _maxBatchQueries = std::max(maxQueries, (size_t)1);
+}
+
+void SearchServer::setSlowQueryLog(const string& logPath, int thresholdMs, double sampleRate, size_t capacity) {
+    _slowLog.reset(new SlowQueryLog(logPath, (int64_t)std::max(thresholdMs, 0) * 1000, sampleRate, capacity));
+}
+
+void SearchServer::warmupCache() {
+    // 快照中保存的是响应缓存 key，还原为查询后去重，按全部字段回放
+    vector<string> queries;
+    std::unordered_set<string> seen;
+    for (const auto& key : _warmer->loadWarmupQueries(_warmupQueries)) {
+        string query = queryOfCacheKey(key);
+        if (seen.insert(query).second) {
+            queries.push_back(std::move(query));
+        }
+    }
+    if (!queries.empty()) {
+        LOG_INFO("Cache warmup: replaying " + std::to_string(queries.size()) + " queries with "
+                 + std::to_string(_warmupThreads) + " threads");
+        CacheWarmer::replay(queries, _warmupThreads, [this](const string& query) {
+            if (_running.load()) {
+                handleSearch(query);
+            }
+        });
+        LOG_INFO("Cache warmup complete, cache size: " + std::to_string(_cache->size()));
+    }
+    _ready = true;
+}
+
+void SearchServer::snapshotLoop() {
+    std::unique_lock<std::mutex> lock(_shutdownMutex);
+    while (!_shutdownCv.wait_for(lock, std::chrono::seconds(_snapshotInterval),
+                                 [this] { return !_running.load(); })) {
+        lock.unlock();
+        _warmer->flushQueryLog();
+        // 预热期间缓存尚未反映真实流量，跳过快照避免覆盖上一次的热点
+        if (_ready.load()) {
+            _warmer->saveSnapshot(_cache->hottestKeys(_warmupQueries));
+        }
+        lock.lock();
+    }
+}
+
+static string formatMB(size_t bytes) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.1f MB", bytes / 1048576.0);
+    return buf;
+}
+
 void SearchServer::start() {
     HttpServer server;
 
     // 搜索接口
-    server.GET("/search", [this](const HttpReq* req, HttpResp* resp) {
+    server.GET("/search", [this](const HttpReq* req, HttpResp* resp, SeriesWork* series) {
+        Metrics::getInstance()->countRequest(ENDPOINT_SEARCH);
         string query = req->query("q");
         if (query.empty()) {
             json error;
@@ -116,15 +221,92 @@ void SearchServer::start() {
             resp->String(error.dump());
             return;
         }
-        query = urlDecode(query);
-        string result = handleSearch(query);
+        {
+            StageTimer timer(STAGE_URL_DECODE);
+            query = urlDecode(query);
+        }
+        if (_warmer) {
+            _warmer->recordQuery(query);
+        }
+        resp->set_header_pair("Content-Type", "application/json; charset=utf-8");
+        resp->set_header_pair("Access-Control-Allow-Origin", "*");
+
+        SearchPage page;
+        const string& cursor = req->query("cursor");
+        if (!cursor.empty()) {
+            if (!decodeCursor(cursor, page)) {
+                replyError(resp, 400, "Invalid cursor");
+                return;
+            }
+        } else {
+            page.from = std::min(std::max(std::atoi(req->query("from").c_str()), 0), SearchPage::MAX_WINDOW);
+        }
+        const string& sizeStr = req->query("size");
+        if (!sizeStr.empty()) {
+            page.size = std::min(std::max(std::atoi(sizeStr.c_str()), 1), SearchPage::MAX_SIZE);
+        }
+        if (page.from + page.size > SearchPage::MAX_WINDOW) {
+            replyError(resp, 400, "from + size must not exceed " + std::to_string(SearchPage::MAX_WINDOW)
+                                  + ", use cursor for deep paging");
+            return;
+        }
+
+        unsigned fields = FIELD_ALL;
+        if (!parseFields(urlDecode(req->query("fields")), fields)) {
+            replyError(resp, 400, "Invalid fields, expected a comma-separated subset of id,score,title,url,summary");
+            return;
+        }
+
+        if (req->query("explain") == "1") {
+            handleExplain(query, fields, resp, series);
+            return;
+        }
+        handleSearchSeries(query, page, fields, requestDeadlineMs(req, _requestDeadlineMs), resp, series);
+    });
+
+    // 批量搜索接口：POST {"queries": ["q1", "q2", ...]}
+    server.POST("/msearch", [this](const HttpReq* req, HttpResp* resp, SeriesWork* series) {
+        Metrics::getInstance()->countRequest(ENDPOINT_MSEARCH);
         resp->set_header_pair("Content-Type", "application/json; charset=utf-8");
         resp->set_header_pair("Access-Control-Allow-Origin", "*");
-        resp->String(result);
+
+        json body = json::parse(req->body(), nullptr, false);
+        if (body.is_discarded() || !body.is_object() || !body.contains("queries") || !body["queries"].is_array()) {
+            replyError(resp, 400, "Request body must be {\"queries\": [...]}");
+            return;
+        }
+
+        unsigned fields = FIELD_ALL;
+        if (body.contains("fields") && (!body["fields"].is_string()
+                                        || !parseFields(body["fields"].get<string>(), fields))) {
+            replyError(resp, 400, "Invalid fields, expected a comma-separated subset of id,score,title,url,summary");
+            return;
+        }
+
+        const json& items = body["queries"];
+        if (items.size() > _maxBatchQueries) {
+            replyError(resp, 400, "Too many queries, limit is " + std::to_string(_maxBatchQueries));
+            return;
+        }
+
+        vector<string> queries;
+        queries.reserve(items.size());
+        for (const auto& item : items) {
+            if (!item.is_string()) {
+                replyError(resp, 400, "Every query must be a string");
+                return;
+            }
+            queries.push_back(item.get<string>());
+            if (_warmer) {
+                _warmer->recordQuery(queries.back());
+            }
+        }
+        handleMultiSearch(queries, fields, requestDeadlineMs(req, _requestDeadlineMs), resp, series);
     });
 
-    // 关键词推荐接口
-    server.GET("/suggest", [this](const HttpReq* req, HttpResp* resp) {
+    // 关键词推荐接口：编辑距离扫描词典较慢，放到独立计算队列
+    server.GET("/suggest", [this](const HttpReq* req, HttpResp* resp, SeriesWork* series) {
+        Metrics::getInstance()->countRequest(ENDPOINT_SUGGEST);
         string query = req->query("q");
         if (query.empty()) {
             json error;
@@ -134,22 +316,86 @@ void SearchServer::start() {
             return;
         }
         query = urlDecode(query);
-        string result = handleSuggest(query);
         resp->set_header_pair("Content-Type", "application/json; charset=utf-8");
         resp->set_header_pair("Access-Control-Allow-Origin", "*");
-        resp->String(result);
+
+        auto result = std::make_shared<string>();
+        WFGoTask* task = WFTaskFactory::create_go_task(SUGGEST_QUEUE, [this, query, result]() {
+            StageTimer timer(STAGE_SUGGEST);
+            *result = handleSuggest(query);
+        });
+        task->set_callback([result, resp](WFGoTask*) {
+            resp->String(std::move(*result));
+        });
+        series->push_back(task);
     });
 
     // 健康检查
     server.GET("/health", [this](const HttpReq* req, HttpResp* resp) {
         json health;
-        health["status"] = "ok";
+        if (!_ready.load()) {
+            // 预热未完成：通知负载均衡暂不导入流量
+            health["status"] = "warming";
+            resp->set_status(503);
+        } else {
+            health["status"] = "ok";
+        }
         health["cache_size"] = _cache->size();
         health["cache_hit_rate"] = _cache->hitRate();
+        health["cache_hits"] = _cache->hits();
+        health["cache_lookups"] = _cache->lookups();
+        if (HotTermCache* termCache = _index->getTermCache()) {
+            health["term_cache_size"] = termCache->termCount();
+            health["term_cache_hit_rate"] = termCache->termHitRate();
+            health["pair_cache_size"] = termCache->pairCount();
+            health["pair_cache_hit_rate"] = termCache->pairHitRate();
+        }
+        if (_snippetCache) {
+            health["snippet_cache_size"] = _snippetCache->size();
+            health["snippet_cache_hit_rate"] = _snippetCache->hitRate();
+        }
+        if (_admission) {
+            health["inflight"] = _admission->inflight();
+            health["service_time_ms"] = _admission->serviceTimeUs() / 1000.0;
+            health["queue_time_ms"] = _admission->queueTimeUs() / 1000.0;
+            health["expected_latency_ms"] = _admission->expectedLatencyUs() / 1000.0;
+            health["admitted"] = _admission->admittedCount();
+            health["degraded"] = _admission->degradedCount();
+            health["rejected"] = _admission->rejectedCount();
+        }
         resp->set_header_pair("Content-Type", "application/json; charset=utf-8");
         resp->String(health.dump());
     });
 
+    // Prometheus 指标
+    server.GET("/metrics", [this](const HttpReq* req, HttpResp* resp) {
+        string out;
+        Metrics::getInstance()->render(out);
+        renderCacheMetrics(out);
+        resp->set_header_pair("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+        resp->String(std::move(out));
+    });
+
+    // 各组件内存占用
+    server.GET("/stats", [this](const HttpReq* req, HttpResp* resp) {
+        string out;
+        renderStats(out);
+        resp->set_header_pair("Content-Type", "application/json; charset=utf-8");
+        resp->String(std::move(out));
+    });
+
+    // 慢查询记录
+    server.GET("/debug/slow", [this](const HttpReq* req, HttpResp* resp) {
+        resp->set_header_pair("Content-Type", "application/json; charset=utf-8");
+        if (!_slowLog) {
+            replyError(resp, 404, "Slow query log is not enabled");
+            return;
+        }
+        string out;
+        _slowLog->render(out);
+        resp->String(std::move(out));
+    });
+
     // 静态文件（搜索页面）
     server.GET("/", [](const HttpReq* req, HttpResp* resp) {
         resp->File("static/index.html");
@@ -161,19 +407,50 @@ void SearchServer::start() {
         resp->File(path.substr(1));
     });
 
+    _loadedMemory = loadedMemory();
+    size_t loadedTotal = 0;
+    for (const auto& component : _loadedMemory) {
+        LOG_INFO("Memory " + component.first + ": " + formatMB(component.second));
+        loadedTotal += component.second;
+    }
+    ProcessMemory process = processMemory();
+    LOG_INFO("Memory total: components " + formatMB(loadedTotal) + ", heap in use "
+             + formatMB(process.heapInUse) + ", rss " + formatMB(process.residentBytes));
+
     LOG_INFO("Search server starting on " + _ip + ":" + std::to_string(_port));
     LOG_INFO("Cache capacity: 1000 entries");
     LOG_INFO("Press Ctrl+C to stop the server");
 
+    if (_warmer && _warmupQueries > 0) {
+        _ready = false;
+    }
+
     if (server.start(_port) == 0) {
         server.list_routes();
         _running = true;
 
-        std::unique_lock<std::mutex> lock(_shutdownMutex);
-        _shutdownCv.wait(lock, [this] { return !_running.load(); });
+        if (_warmer) {
+            if (!_ready.load()) {
+                _warmupThread = std::thread(&SearchServer::warmupCache, this);
+            }
+            _snapshotThread = std::thread(&SearchServer::snapshotLoop, this);
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(_shutdownMutex);
+            _shutdownCv.wait(lock, [this] { return !_running.load(); });
+        }
 
         LOG_INFO("Stopping server...");
+        if (_warmupThread.joinable()) _warmupThread.join();
+        if (_snapshotThread.joinable()) _snapshotThread.join();
         server.stop();
+        if (_warmer) {
+            _warmer->flushQueryLog();
+            if (_ready.load()) {
+                _warmer->saveSnapshot(_cache->hottestKeys(_warmupQueries));
+            }
+        }
         LOG_INFO("Server stopped gracefully");
     } else {
         LOG_ERROR("Failed to start server");
@@ -202,78 +479,978 @@ string SearchServer::handleSearch(const string& query) {
     return response;
 }
 
+// 一次搜索请求在 series 各阶段之间共享的上下文：由计算任务、各 I/O 回调、超时定时器共同持有
+struct SearchContext {
+    string query;
+    SearchPage page;
+    unsigned fields = FIELD_ALL;
+    string cacheKey;                          // 响应缓存 key，为空表示响应不缓存（非首页）
+    std::chrono::steady_clock::time_point arrival = std::chrono::steady_clock::now();
+    int64_t deadlineUs = 0;                   // 相对 arrival 的截止时间
+    int64_t queueUs = 0;                      // 在计算队列中的排队耗时
+    bool admitted = false;                    // 占用了准入名额，完成时需归还
+    bool degraded = false;                    // 饱和降级：只返回标题
+
+    vector<string> queryWords;
+    vector<pair<int, double>> results;
+    string termKey;
+    string response;                          // 已生成的响应，非空表示无需后续阶段
+
+    // 慢查询追踪：各时间点只是一次取时；检索只收集几个计数器，各查询词概况在确定记录时才补全
+    int64_t trace[TRACE_COUNT];
+    SearchStats stats;
+    bool sampled = false;                     // 请求开始时决定的慢查询日志随机采样
+
+    SearchContext() {
+        std::fill(trace, trace + TRACE_COUNT, -1);
+    }
+
+    void mark(TracePoint point) {
+        trace[point] = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - arrival).count();
+    }
+
+    vector<string> summaries;                 // 与 results 一一对应
+    vector<size_t> pending;                   // 需要从磁盘读取摘要的结果下标
+    vector<string> buffers;                   // 各结果的正文读取缓冲
+    std::unique_ptr<std::atomic<long>[]> readLens;  // 读取完成的字节数，-1 表示未完成
+
+    std::chrono::steady_clock::time_point snippetStart;
+    std::atomic<bool> finished{false};
+    WFCounterTask* counter = nullptr;
+
+    // 全部读取完成或超时，先到者唤醒 series 中等待的计数任务
+    void finish() {
+        if (!finished.exchange(true)) {
+            counter->count();
+        }
+    }
+};
+
+void SearchServer::configureThreads(int computeThreads, int pollerThreads, int handlerThreads) {
+    struct WFGlobalSettings settings = GLOBAL_SETTINGS_DEFAULT;
+    if (computeThreads > 0) settings.compute_threads = computeThreads;
+    if (pollerThreads > 0) settings.poller_threads = pollerThreads;
+    if (handlerThreads > 0) settings.handler_threads = handlerThreads;
+    WORKFLOW_library_init(&settings);
+}
+
+static int64_t elapsedUs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - since).count();
+}
+
+void SearchServer::handleSearchSeries(const string& query, const SearchPage& page, unsigned fields,
+                                      int deadlineMs, HttpResp* resp, SeriesWork* series) {
+    auto ctx = std::make_shared<SearchContext>();
+    ctx->query = query;
+    ctx->page = page;
+    ctx->fields = fields;
+
+    // 只有首页缓存整个响应；后续页由排序列表缓存加速
+    if (page.isFirstPage()) {
+        ctx->cacheKey = responseCacheKey(query, fields);
+
+        // 缓存命中很便宜，直接在网络线程返回
+        string cachedResult;
+        StageTimer lookupTimer(STAGE_CACHE_LOOKUP);
+        bool hit = _cache->get(ctx->cacheKey, cachedResult);
+        lookupTimer.stop();
+        if (hit) {
+            _cache->recordQuery(true);
+            resp->String(std::move(cachedResult));
+            Metrics::getInstance()->record(STAGE_REQUEST, elapsedUs(ctx->arrival));
+            return;
+        }
+        _cache->recordQuery(false);
+    }
+
+    ctx->deadlineUs = (int64_t)deadlineMs * 1000;
+    ctx->sampled = _slowLog && _slowLog->sample();
+
+    if (_admission) {
+        AdmissionController::Decision decision = _admission->admit(ctx->deadlineUs);
+        if (decision == AdmissionController::REJECT) {
+            rejectOverloaded(resp);
+            return;
+        }
+        ctx->admitted = true;
+        ctx->degraded = (decision == AdmissionController::DEGRADE);
+    }
+
+    // 阶段一（计算队列）：分词、检索，同步模式下顺带生成摘要和响应
+    WFGoTask* retrieve = WFTaskFactory::create_go_task(SEARCH_QUEUE, [this, ctx]() {
+        ctx->queueUs = elapsedUs(ctx->arrival);
+        ctx->trace[TRACE_DEQUEUED] = ctx->queueUs;
+        if (ctx->admitted) {
+            _admission->recordQueueTime(ctx->queueUs);
+        }
+        retrieveStage(*ctx);
+    });
+    retrieve->set_callback([this, ctx, resp](WFGoTask* task) {
+        if (!ctx->response.empty()) {
+            completeSearch(*ctx, resp);
+            return;
+        }
+        // 阶段二（I/O 引擎）：并发读取摘要
+        fetchSnippets(ctx, resp, series_of(task));
+    });
+    series->push_back(retrieve);
+}
+
+void SearchServer::retrieveStage(SearchContext& ctx) {
+    {
+        StageTimer timer(STAGE_TOKENIZE);
+        ctx.queryWords = _splitTool->cut(ctx.query);
+    }
+    ctx.mark(TRACE_TOKENIZED);
+    {
+        StageTimer timer(STAGE_RETRIEVAL);
+        ctx.results = ctx.page.isFirstPage()
+            ? _index->search(ctx.queryWords, SearchPage::DEFAULT_SIZE, &ctx.stats)
+            : rankedPage(ctx.queryWords, ctx.page);
+    }
+    ctx.mark(TRACE_RETRIEVED);
+    int pageSize = ctx.page.size;
+
+    if (ctx.degraded) {
+        // 饱和降级：跳过摘要生成和正文读取，只带上摘要缓存中已有的结果；降级响应不进入缓存
+        string termKey = _snippetCache ? snippetTermKey(ctx.queryWords) : string();
+        vector<string> summaries(ctx.results.size());
+        if (_snippetCache && (ctx.fields & FIELD_SUMMARY)) {
+            for (size_t i = 0; i < summaries.size(); ++i) {
+                getCachedSummary(ctx.results[i].first, termKey, summaries[i]);
+            }
+        }
+        ctx.response = generateResponse(ctx.query, ctx.results, ctx.queryWords, &summaries,
+                                        pageSize, ctx.fields);
+        ctx.mark(TRACE_SERIALIZED);
+        return;
+    }
+
+    // 未请求摘要时无需读取正文，直接生成响应
+    if (!(_useLiteMode && _asyncSnippet) || !(ctx.fields & FIELD_SUMMARY)) {
+        ctx.response = generateResponse(ctx.query, ctx.results, ctx.queryWords, nullptr,
+                                        pageSize, ctx.fields);
+        ctx.mark(TRACE_SERIALIZED);
+        if (!ctx.cacheKey.empty()) {
+            _cache->put(ctx.cacheKey, ctx.response);
+        }
+        return;
+    }
+
+    ctx.termKey = _snippetCache ? snippetTermKey(ctx.queryWords) : string();
+
+    size_t n = ctx.results.size();
+    ctx.summaries.resize(n);
+    ctx.buffers.resize(n);
+    ctx.readLens.reset(new std::atomic<long>[n]);
+
+    for (size_t i = 0; i < n; ++i) {
+        ctx.readLens[i].store(-1, std::memory_order_relaxed);
+        int docId = ctx.results[i].first;
+        if (_pageMetaLib.find(docId) == _pageMetaLib.end()) continue;
+        if (!getCachedSummary(docId, ctx.termKey, ctx.summaries[i])) {
+            ctx.pending.push_back(i);
+        }
+    }
+
+    if (ctx.pending.empty()) {
+        ctx.response = generateResponse(ctx.query, ctx.results, ctx.queryWords, &ctx.summaries,
+                                        pageSize, ctx.fields);
+        ctx.mark(TRACE_SERIALIZED);
+        if (!ctx.cacheKey.empty()) {
+            _cache->put(ctx.cacheKey, ctx.response);
+        }
+    }
+}
+
+void SearchServer::fetchSnippets(const shared_ptr<SearchContext>& ctx, HttpResp* resp, SeriesWork* series) {
+    ctx->snippetStart = std::chrono::steady_clock::now();
+
+    // 全部读取完成或超时后，阶段三（计算队列）：生成摘要并序列化
+    ctx->counter = WFTaskFactory::create_counter_task(1, [this, ctx, resp](WFCounterTask* counter) {
+        WFGoTask* assemble = WFTaskFactory::create_go_task(SEARCH_QUEUE, [this, ctx]() {
+            assembleStage(*ctx);
+        });
+        assemble->set_callback([this, ctx, resp](WFGoTask*) {
+            completeSearch(*ctx, resp);
+        });
+        series_of(counter)->push_back(assemble);
+    });
+
+    ParallelWork* pwork = Workflow::create_parallel_work([ctx](const ParallelWork*) {
+        ctx->finish();
+    });
+    for (size_t i : ctx->pending) {
+        const auto& meta = _pageMetaLib.find(ctx->results[i].first)->second;
+        ctx->buffers[i].resize(std::min(meta.contentLength, ContentStore::SUMMARY_READ_BYTES));
+
+        WFFileIOTask* task = WFTaskFactory::create_pread_task(
+            _contentStore->fd(), &ctx->buffers[i][0], ctx->buffers[i].size(),
+            meta.contentOffset,
+            [ctx, i](WFFileIOTask* task) {
+                if (task->get_state() == WFT_STATE_SUCCESS && task->get_retval() >= 0) {
+                    ctx->readLens[i].store(task->get_retval(), std::memory_order_release);
+                }
+            });
+        pwork->add_series(Workflow::create_series_work(task, nullptr));
+    }
+
+    // 摘要等待时间不超过请求剩余的截止时间
+    int64_t remainingUs = ctx->deadlineUs - elapsedUs(ctx->arrival);
+    int64_t waitUs = std::max(std::min((int64_t)_snippetDeadlineMs * 1000, remainingUs), (int64_t)1000);
+    WFTimerTask* timer = WFTaskFactory::create_timer_task(
+        waitUs, [ctx](WFTimerTask*) {
+            ctx->finish();
+        });
+
+    series->push_back(ctx->counter);
+    Workflow::start_series_work(pwork, nullptr);
+    timer->start();
+}
+
+void SearchServer::assembleStage(SearchContext& ctx) {
+    ctx.mark(TRACE_SNIPPETS_READ);
+    bool complete = true;
+    for (size_t i : ctx.pending) {
+        long len = ctx.readLens[i].load(std::memory_order_acquire);
+        if (len < 0) {
+            complete = false;  // 超时未完成：只返回标题
+            continue;
+        }
+        const auto& meta = _pageMetaLib.find(ctx.results[i].first)->second;
+        ctx.summaries[i] = ContentStore::summarize(
+            string_view(ctx.buffers[i].data(), len), ctx.queryWords,
+            _contentStore->segments(meta.segOffset, meta.segCount), meta.segCount);
+        putCachedSummary(ctx.results[i].first, ctx.termKey, ctx.summaries[i]);
+    }
+    // 摘要阶段含等待磁盘读取的时间
+    Metrics::getInstance()->record(STAGE_SNIPPET, elapsedUs(ctx.snippetStart));
+
+    ctx.response = generateResponse(ctx.query, ctx.results, ctx.queryWords, &ctx.summaries,
+                                    ctx.page.size, ctx.fields);
+    ctx.mark(TRACE_SERIALIZED);
+    // 降级结果不进入缓存，避免残缺响应被反复命中
+    if (complete && !ctx.cacheKey.empty()) {
+        _cache->put(ctx.cacheKey, ctx.response);
+    }
+}
+
+void SearchServer::handleExplain(const string& query, unsigned fields, HttpResp* resp, SeriesWork* series) {
+    auto output = std::make_shared<string>();
+    WFGoTask* task = WFTaskFactory::create_go_task(SEARCH_QUEUE, [this, query, fields, output]() {
+        auto start = std::chrono::steady_clock::now();
+        bool resultCached = _cache->contains(responseCacheKey(query, fields));
+
+        auto stageStart = std::chrono::steady_clock::now();
+        vector<string> queryWords = _splitTool->cut(query);
+        int64_t tokenizeUs = elapsedUs(stageStart);
+
+        SearchStats stats;
+        stageStart = std::chrono::steady_clock::now();
+        vector<pair<int, double>> results = _index->search(queryWords, SearchPage::DEFAULT_SIZE, &stats, false);
+        _index->describeTerms(queryWords, stats);
+        int64_t retrievalUs = elapsedUs(stageStart);
+
+        // 摘要单独生成以区分缓存命中；只读缓存（peek 不调整 LRU 顺序、不计命中率），不回填
+        stageStart = std::chrono::steady_clock::now();
+        size_t snippetHits = 0;
+        size_t snippetMisses = 0;
+        vector<string> summaries(results.size());
+        if (fields & FIELD_SUMMARY) {
+            string termKey = _snippetCache ? snippetTermKey(queryWords) : string();
+            for (size_t i = 0; i < results.size(); ++i) {
+                int docId = results[i].first;
+                if (_snippetCache && _snippetCache->peek(std::to_string(docId) + termKey, summaries[i])) {
+                    snippetHits++;
+                    continue;
+                }
+                snippetMisses++;
+                if (_useLiteMode) {
+                    auto it = _pageMetaLib.find(docId);
+                    if (it != _pageMetaLib.end()) {
+                        summaries[i] = _contentStore->getSummary(it->second, queryWords);
+                    }
+                } else {
+                    auto it = _pageLib.find(docId);
+                    if (it != _pageLib.end()) {
+                        summaries[i] = it->second->getSummary(queryWords);
+                    }
+                }
+            }
+        }
+        int64_t snippetUs = elapsedUs(stageStart);
+
+        stageStart = std::chrono::steady_clock::now();
+        string response = generateResponse(query, results, queryWords, &summaries,
+                                           SearchPage::DEFAULT_SIZE, fields, false);
+        int64_t serializeUs = elapsedUs(stageStart);
+
+        JsonWriter writer(*output);
+        writer.beginObject();
+        writer.key("query").value(query);
+
+        writer.key("tokens").beginArray();
+        for (const auto& word : queryWords) {
+            writer.value(word);
+        }
+        writer.endArray();
+
+        writer.key("cache").beginObject();
+        writer.key("result").value(resultCached ? "hit" : "miss");
+        writer.key("snippet_enabled").value(_snippetCache != nullptr);
+        writer.key("snippet_hits").value(snippetHits);
+        writer.key("snippet_misses").value(snippetMisses);
+        writer.endObject();
+
+        writer.key("retrieval").beginObject();
+        writer.key("path").value(stats.path);
+        writer.key("fallback").value(stats.fallback);
+        writer.key("postings_scored").value(stats.postingsScored);
+        writer.key("docs_touched").value(stats.docsTouched);
+        writer.key("results").value(results.size());
+        writer.key("terms").beginArray();
+        for (const auto& term : stats.terms) {
+            writer.beginObject();
+            writer.key("term").value(term.term);
+            writer.key("count").value(term.count);
+            writer.key("postings").value(term.postings);
+            writer.key("max_impact").value(term.maxImpact);
+            writer.key("hot").value(term.hot);
+            writer.endObject();
+        }
+        writer.endArray();
+        writer.endObject();
+
+        writer.key("stages_us").beginObject();
+        writer.key("tokenize").value(tokenizeUs);
+        writer.key("retrieval").value(retrievalUs);
+        writer.key("snippet").value(snippetUs);
+        writer.key("serialize").value(serializeUs);
+        writer.key("total").value(elapsedUs(start));
+        writer.endObject();
+
+        writer.key("response").raw(response);
+        writer.endObject();
+    });
+    task->set_callback([resp, output](WFGoTask*) {
+        resp->String(std::move(*output));
+    });
+    series->push_back(task);
+}
+
+// 一次批量搜索的共享上下文
+struct BatchContext {
+    vector<string> queries;                   // 去重后的查询
+    vector<size_t> slots;                     // 请求中第 i 个查询对应 queries 的下标
+    vector<string> responses;                 // 与 queries 一一对应的单条搜索响应
+
+    // 分词结果相同的查询归为一组，每组只检索一次
+    vector<vector<string>> groupWords;
+    vector<vector<size_t>> groupQueries;
+    // 各组用到的词统一解析一次，组之间共享倒排表与热词条目的查找结果
+    ResolvedTerms terms;
+
+    unsigned fields = FIELD_ALL;
+    std::chrono::steady_clock::time_point arrival;
+    bool admitted = false;
+    bool degraded = false;                    // 饱和降级：与 /search 相同，只带摘要缓存中已有的摘要
+};
+
+void SearchServer::handleMultiSearch(const vector<string>& queries, unsigned fields, int deadlineMs,
+                                     HttpResp* resp, SeriesWork* series) {
+    auto ctx = std::make_shared<BatchContext>();
+    ctx->fields = fields;
+    ctx->arrival = std::chrono::steady_clock::now();
+
+    unordered_map<string, size_t> seen;
+    for (const auto& query : queries) {
+        auto res = seen.emplace(query, ctx->queries.size());
+        if (res.second) {
+            ctx->queries.push_back(query);
+        }
+        ctx->slots.push_back(res.first->second);
+    }
+
+    if (_admission) {
+        // 整批作为一个请求占用名额；饱和时与 /search 一样降级为不生成摘要
+        AdmissionController::Decision decision = _admission->admit((int64_t)deadlineMs * 1000);
+        if (decision == AdmissionController::REJECT) {
+            rejectOverloaded(resp);
+            return;
+        }
+        ctx->admitted = true;
+        ctx->degraded = (decision == AdmissionController::DEGRADE);
+    }
+
+    // 阶段一（计算队列）：查缓存，未命中的查询分词、按词序列分组，并解析整批用到的词
+    WFGoTask* plan = WFTaskFactory::create_go_task(SEARCH_QUEUE, [this, ctx]() {
+        ctx->responses.resize(ctx->queries.size());
+        unordered_map<string, size_t> groupIndex;
+        for (size_t i = 0; i < ctx->queries.size(); ++i) {
+            bool hit = _cache->get(responseCacheKey(ctx->queries[i], ctx->fields), ctx->responses[i]);
+            _cache->recordQuery(hit);
+            if (hit) {
+                continue;
+            }
+            vector<string> words = _splitTool->cut(ctx->queries[i]);
+            auto res = groupIndex.emplace(rankingKey(words), ctx->groupWords.size());
+            if (res.second) {
+                ctx->groupWords.push_back(std::move(words));
+                ctx->groupQueries.emplace_back();
+            }
+            ctx->groupQueries[res.first->second].push_back(i);
+        }
+        if (!ctx->groupWords.empty()) {
+            ctx->terms = _index->resolveTerms(ctx->groupWords);
+        }
+    });
+
+    // 阶段二：每组一个计算任务并行检索，全部完成后拼接响应
+    plan->set_callback([this, ctx, resp](WFGoTask* task) {
+        if (ctx->groupWords.empty()) {
+            completeMultiSearch(*ctx, resp);
+            return;
+        }
+        ParallelWork* pwork = Workflow::create_parallel_work([this, ctx, resp](const ParallelWork*) {
+            completeMultiSearch(*ctx, resp);
+        });
+        for (size_t g = 0; g < ctx->groupWords.size(); ++g) {
+            WFGoTask* search = WFTaskFactory::create_go_task(SEARCH_QUEUE, [this, ctx, g]() {
+                const vector<string>& words = ctx->groupWords[g];
+                vector<pair<int, double>> results = _index->search(words, SearchPage::DEFAULT_SIZE, ctx->terms);
+                if (ctx->degraded) {
+                    // 降级：跳过摘要生成，只取摘要缓存中已有的结果；降级响应不进入缓存
+                    vector<string> summaries(results.size());
+                    if (_snippetCache && (ctx->fields & FIELD_SUMMARY)) {
+                        string termKey = snippetTermKey(words);
+                        for (size_t r = 0; r < summaries.size(); ++r) {
+                            getCachedSummary(results[r].first, termKey, summaries[r]);
+                        }
+                    }
+                    for (size_t i : ctx->groupQueries[g]) {
+                        ctx->responses[i] = generateResponse(ctx->queries[i], results, words, &summaries,
+                                                             SearchPage::DEFAULT_SIZE, ctx->fields);
+                    }
+                    return;
+                }
+                for (size_t i : ctx->groupQueries[g]) {
+                    ctx->responses[i] = generateResponse(ctx->queries[i], results, words, nullptr,
+                                                         SearchPage::DEFAULT_SIZE, ctx->fields);
+                    _cache->put(responseCacheKey(ctx->queries[i], ctx->fields), ctx->responses[i]);
+                }
+            });
+            pwork->add_series(Workflow::create_series_work(search, nullptr));
+        }
+        series_of(task)->push_back(pwork);
+    });
+    series->push_back(plan);
+}
+
+void SearchServer::completeMultiSearch(BatchContext& ctx, HttpResp* resp) {
+    // 各查询的响应大小已知，一次分配到位后移交给响应
+    size_t bytes = 64;
+    for (size_t slot : ctx.slots) {
+        bytes += ctx.responses[slot].size() + 1;
+    }
+    string body;
+    body.reserve(bytes);
+    JsonWriter writer(body);
+    writer.beginObject();
+    writer.key("count").value(ctx.slots.size());
+    writer.key("unique").value(ctx.queries.size());
+    writer.key("responses").beginArray();
+    for (size_t slot : ctx.slots) {
+        writer.raw(ctx.responses[slot]);
+    }
+    writer.endArray();
+    writer.endObject();
+    // 全部命中缓存时没有降级生成的响应
+    if (ctx.degraded && !ctx.groupWords.empty()) {
+        resp->set_header_pair("X-Degraded", "title-only");
+    }
+    resp->String(std::move(body));
+
+    if (ctx.admitted) {
+        // 整批耗时不代表单次查询的服务时间，不计入估计
+        _admission->release(0, false);
+        ctx.admitted = false;
+    }
+}
+
+void SearchServer::renderCacheMetrics(string& out) {
+    struct CacheView {
+        const char* name;
+        vector<CacheShardStats> shards;
+    };
+    vector<CacheView> caches;
+    caches.push_back({"result", _cache->shardStats()});
+    if (_snippetCache) caches.push_back({"snippet", _snippetCache->shardStats()});
+    if (_rankedCache) caches.push_back({"ranked", _rankedCache->shardStats()});
+
+    Metrics::appendHeader(out, "search_cache_entries", "gauge", "Entries held by each cache.");
+    for (const auto& cache : caches) {
+        size_t entries = 0;
+        for (const auto& shard : cache.shards) entries += shard.size;
+        Metrics::appendSample(out, "search_cache_entries", string("cache=\"") + cache.name + "\"", (double)entries);
+    }
+
+    Metrics::appendHeader(out, "search_cache_hit_ratio", "gauge", "Lifetime hit ratio of each cache.");
+    for (const auto& cache : caches) {
+        uint64_t hits = 0, lookups = 0;
+        for (const auto& shard : cache.shards) {
+            hits += shard.hits;
+            lookups += shard.hits + shard.misses;
+        }
+        Metrics::appendSample(out, "search_cache_hit_ratio", string("cache=\"") + cache.name + "\"",
+                              lookups ? (double)hits / lookups : 0);
+    }
+
+    // 分片级统计：用于发现 key 分布倾斜的热点分片
+    static const struct {
+        const char* metric;
+        const char* type;
+        const char* help;
+    } shardMetrics[] = {
+        {"search_cache_shard_entries", "gauge", "Entries held by each cache shard."},
+        {"search_cache_shard_hits_total", "counter", "Lookups that hit, per cache shard."},
+        {"search_cache_shard_misses_total", "counter", "Lookups that missed, per cache shard."},
+    };
+    for (int m = 0; m < 3; ++m) {
+        Metrics::appendHeader(out, shardMetrics[m].metric, shardMetrics[m].type, shardMetrics[m].help);
+        for (const auto& cache : caches) {
+            for (size_t i = 0; i < cache.shards.size(); ++i) {
+                const auto& shard = cache.shards[i];
+                double value = m == 0 ? shard.size : (m == 1 ? shard.hits : shard.misses);
+                Metrics::appendSample(out, shardMetrics[m].metric,
+                                      string("cache=\"") + cache.name + "\",shard=\"" + std::to_string(i) + "\"",
+                                      value);
+            }
+        }
+    }
+
+    if (HotTermCache* termCache = _index->getTermCache()) {
+        Metrics::appendHeader(out, "search_term_cache_entries", "gauge", "Hot posting prefixes and pair intersections cached.");
+        Metrics::appendSample(out, "search_term_cache_entries", "kind=\"term\"", (double)termCache->termCount());
+        Metrics::appendSample(out, "search_term_cache_entries", "kind=\"pair\"", (double)termCache->pairCount());
+        Metrics::appendHeader(out, "search_term_cache_hit_ratio", "gauge", "Hit ratio of the hot term cache.");
+        Metrics::appendSample(out, "search_term_cache_hit_ratio", "kind=\"term\"", termCache->termHitRate());
+        Metrics::appendSample(out, "search_term_cache_hit_ratio", "kind=\"pair\"", termCache->pairHitRate());
+    }
+
+    if (_admission) {
+        Metrics::appendHeader(out, "search_inflight", "gauge", "Searches currently admitted and not yet answered.");
+        Metrics::appendSample(out, "search_inflight", "", (double)_admission->inflight());
+        Metrics::appendHeader(out, "search_expected_latency_seconds", "gauge", "Admission controller latency estimate for a new search.");
+        Metrics::appendSample(out, "search_expected_latency_seconds", "", _admission->expectedLatencyUs() / 1e6);
+        Metrics::appendHeader(out, "search_admission_total", "counter", "Admission decisions for searches that missed the cache.");
+        Metrics::appendSample(out, "search_admission_total", "decision=\"admit\"", (double)_admission->admittedCount());
+        Metrics::appendSample(out, "search_admission_total", "decision=\"degrade\"", (double)_admission->degradedCount());
+        Metrics::appendSample(out, "search_admission_total", "decision=\"reject\"", (double)_admission->rejectedCount());
+    }
+}
+
+void SearchServer::rejectOverloaded(HttpResp* resp) {
+    // 预计无法在截止时间内完成：尽早拒绝，让客户端重试其他实例
+    json error;
+    error["error"] = "Server overloaded";
+    error["expected_latency_ms"] = _admission->expectedLatencyUs() / 1000;
+    resp->set_status(503);
+    resp->set_header_pair("Retry-After", "1");
+    resp->String(error.dump());
+    Metrics::getInstance()->countError(503);
+}
+
+void SearchServer::completeSearch(SearchContext& ctx, HttpResp* resp) {
+    if (ctx.degraded) {
+        resp->set_header_pair("X-Degraded", "title-only");
+    }
+    resp->String(std::move(ctx.response));
+    int64_t totalUs = elapsedUs(ctx.arrival);
+    Metrics::getInstance()->record(STAGE_REQUEST, totalUs);
+    if (ctx.admitted) {
+        _admission->release(totalUs - ctx.queueUs, !ctx.degraded);
+        ctx.admitted = false;
+    }
+
+    if (_slowLog && (ctx.sampled || _slowLog->overThreshold(totalUs))) {
+        if (!ctx.stats.path.empty()) {
+            _index->describeTerms(ctx.queryWords, ctx.stats);
+        }
+        SlowQueryRecord rec;
+        rec.query = ctx.query;
+        rec.from = ctx.page.from;
+        rec.size = ctx.page.size;
+        rec.fields = ctx.fields;
+        rec.degraded = ctx.degraded;
+        rec.sampled = ctx.sampled && !_slowLog->overThreshold(totalUs);
+        rec.results = ctx.results.size();
+        rec.totalUs = totalUs;
+        std::copy(ctx.trace, ctx.trace + TRACE_COUNT, rec.trace);
+        rec.stats = std::move(ctx.stats);
+        _slowLog->record(rec);
+    }
+}
+
+vector<pair<string, size_t>> SearchServer::loadedMemory() const {
+    vector<pair<string, size_t>> components;
+    components.emplace_back("index_postings", _index->postingsMemory());
+    components.emplace_back("doc_lens", _index->docLensMemory());
+
+    size_t pageMetaBytes = hashTableBytes(_pageMetaLib);
+    for (const auto& entry : _pageMetaLib) {
+        pageMetaBytes += heapBytes(entry.second.titleJson) + heapBytes(entry.second.urlJson);
+    }
+    components.emplace_back("page_meta", pageMetaBytes);
+
+    // 网页对象由 make_shared 分配，控制块与对象在同一块内存中
+    size_t pageLibBytes = _pageLib.size() * treeNodeBytes<map<int, shared_ptr<WebPage>>::value_type>();
+    for (const auto& entry : _pageLib) {
+        pageLibBytes += mallocBytes(sizeof(WebPage) + 16) + entry.second->memoryUsage();
+    }
+    components.emplace_back("page_lib", pageLibBytes);
+
+    components.emplace_back("dict", _dictProducer ? _dictProducer->memoryUsage() : 0);
+    return components;
+}
+
+vector<pair<string, size_t>> SearchServer::cacheMemory() {
+    vector<pair<string, size_t>> components;
+    components.emplace_back("result_cache", _cache->memoryUsage());
+    components.emplace_back("snippet_cache", _snippetCache ? _snippetCache->memoryUsage() : 0);
+    components.emplace_back("ranked_cache", _rankedCache
+        ? _rankedCache->memoryUsage([](const shared_ptr<const RankedList>& list) {
+              return mallocBytes(sizeof(RankedList) + 16) + vectorHeapBytes(list->items);
+          })
+        : 0);
+    HotTermCache* termCache = _index->getTermCache();
+    components.emplace_back("term_cache", termCache ? termCache->memoryUsage() : 0);
+    return components;
+}
+
+void SearchServer::renderStats(string& out) {
+    vector<pair<string, size_t>> components = _loadedMemory;
+    for (auto& component : cacheMemory()) {
+        components.push_back(std::move(component));
+    }
+    size_t total = 0;
+    for (const auto& component : components) {
+        total += component.second;
+    }
+    ProcessMemory process = processMemory();
+    int docs = _index->getTotalDocs();
+
+    JsonWriter writer(out);
+    writer.beginObject();
+    writer.key("mode").value(_useLiteMode ? "lite" : "traditional");
+    writer.key("docs").value(docs);
+
+    writer.key("memory").beginObject();
+    writer.key("components").beginObject();
+    for (const auto& component : components) {
+        writer.key(component.first).value(component.second);
+    }
+    writer.endObject();
+    writer.key("components_total").value(total);
+    writer.key("bytes_per_doc").value(docs > 0 ? (double)total / docs : 0.0);
+    // 分配器统计与估算之差：未纳入统计的组件、分配器碎片以及估算误差
+    writer.key("unaccounted").value((int64_t)process.heapInUse - (int64_t)total);
+    writer.key("process").beginObject();
+    writer.key("rss").value(process.residentBytes);
+    writer.key("heap_in_use").value(process.heapInUse);
+    writer.key("heap_free").value(process.heapFree);
+    writer.key("heap_mapped").value(process.heapMapped);
+    writer.endObject();
+    writer.endObject();
+
+    writer.endObject();
+}
+
 string SearchServer::handleSuggest(const string& query) {
     if (!_recommender) {
-        json response;
-        response["query"] = query;
-        response["suggestions"] = json::array();
-        return response.dump();
+        return generateSuggestResponse(query, {});
     }
 
     vector<string> suggestions = _recommender->recommend(query, 5, 2);
     return generateSuggestResponse(query, suggestions);
 }
 
+bool SearchServer::parseFields(const string& spec, unsigned& fields) {
+    if (spec.empty()) {
+        fields = FIELD_ALL;
+        return true;
+    }
+
+    static const unordered_map<string, unsigned> names = {
+        {"id", FIELD_ID}, {"docId", FIELD_ID}, {"score", FIELD_SCORE},
+        {"title", FIELD_TITLE}, {"url", FIELD_URL}, {"summary", FIELD_SUMMARY}
+    };
+    fields = 0;
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == string::npos) end = spec.size();
+        string name = spec.substr(start, end - start);
+        if (!name.empty()) {
+            auto it = names.find(name);
+            if (it == names.end()) {
+                return false;
+            }
+            fields |= it->second;
+        }
+        start = end + 1;
+    }
+    return fields != 0;
+}
+
+// 字段集后缀分隔符，不会出现在 URL 解码后的正常查询中
+static const char FIELD_KEY_SEP = '\x1e';
+
+string SearchServer::responseCacheKey(const string& query, unsigned fields) {
+    if (fields == FIELD_ALL) {
+        return query;
+    }
+    return query + FIELD_KEY_SEP + std::to_string(fields);
+}
+
+string SearchServer::queryOfCacheKey(const string& key) {
+    return key.substr(0, key.find(FIELD_KEY_SEP));
+}
+
+string SearchServer::rankingKey(const vector<string>& queryWords) {
+    // BM25 得分与词序无关，但重复词会重复计分，因此只排序不去重
+    vector<string> terms(queryWords);
+    std::sort(terms.begin(), terms.end());
+
+    string key;
+    for (const auto& term : terms) {
+        key += term;
+        key += '\x1f';
+    }
+    return key;
+}
+
+vector<pair<int, double>> SearchServer::rankedPage(const vector<string>& queryWords, const SearchPage& page) {
+    string key = _rankedCache ? rankingKey(queryWords) : string();
+    shared_ptr<const RankedList> list;
+    bool cached = _rankedCache && _rankedCache->get(key, list);
+
+    if (page.hasCursor) {
+        if (cached) {
+            // 在缓存列表中定位游标之后的第一条
+            pair<int, double> after(page.afterDocId, page.afterScore);
+            auto it = std::upper_bound(list->items.begin(), list->items.end(), after,
+                                       InvertIndex::rankBefore);
+            size_t pos = it - list->items.begin();
+            if (pos + page.size <= list->items.size() || list->exhausted) {
+                size_t end = std::min(pos + page.size, list->items.size());
+                return vector<pair<int, double>>(list->items.begin() + pos, list->items.begin() + end);
+            }
+        }
+        // 超出缓存深度：从索引续查，只需维护 size 大小的堆
+        return _index->searchAfter(queryWords, page.size, page.afterScore, page.afterDocId);
+    }
+
+    size_t need = page.from + page.size;
+    if (!cached || (list->items.size() < need && !list->exhausted)) {
+        int depth = std::max((int)need, _rankedDepth);
+        auto fresh = std::make_shared<RankedList>();
+        fresh->items = _index->search(queryWords, depth);
+        fresh->exhausted = fresh->items.size() < (size_t)depth;
+        if (_rankedCache) {
+            _rankedCache->put(key, fresh);
+        }
+        list = fresh;
+    }
+
+    size_t begin = std::min((size_t)page.from, list->items.size());
+    size_t end = std::min(need, list->items.size());
+    return vector<pair<int, double>>(list->items.begin() + begin, list->items.begin() + end);
+}
+
+string SearchServer::encodeCursor(const pair<int, double>& last) {
+    uint64_t bits;
+    memcpy(&bits, &last.second, sizeof(bits));
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%016llx%08x", (unsigned long long)bits, (unsigned)last.first);
+    return string(buf);
+}
+
+bool SearchServer::decodeCursor(const string& cursor, SearchPage& page) {
+    if (cursor.size() != 24 || !std::all_of(cursor.begin(), cursor.end(), ::isxdigit)) {
+        return false;
+    }
+    uint64_t bits = std::stoull(cursor.substr(0, 16), nullptr, 16);
+    memcpy(&page.afterScore, &bits, sizeof(bits));
+    page.afterDocId = (int)std::stoul(cursor.substr(16), nullptr, 16);
+    page.hasCursor = true;
+    page.from = 0;
+    return std::isfinite(page.afterScore);
+}
+
+string SearchServer::snippetTermKey(const vector<string>& queryWords) {
+    vector<string> terms(queryWords);
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+
+    string key;
+    for (const auto& term : terms) {
+        key += '\x1f';
+        key += term;
+    }
+    return key;
+}
+
+bool SearchServer::getCachedSummary(int docId, const string& termKey, string& summary) {
+    if (!_snippetCache) {
+        return false;
+    }
+    bool hit = _snippetCache->get(std::to_string(docId) + termKey, summary);
+    _snippetCache->recordQuery(hit);
+    return hit;
+}
+
+void SearchServer::putCachedSummary(int docId, const string& termKey, const string& summary) {
+    if (_snippetCache) {
+        _snippetCache->put(std::to_string(docId) + termKey, summary);
+    }
+}
+
+string SearchServer::lookupSummary(int docId, const string& termKey,
+                                   const std::function<string()>& compute) {
+    string summary;
+    if (getCachedSummary(docId, termKey, summary)) {
+        return summary;
+    }
+    summary = compute();
+    putCachedSummary(docId, termKey, summary);
+    return summary;
+}
+
 string SearchServer::generateResponse(const string& query,
                                       const vector<pair<int, double>>& results,
-                                      const vector<string>& queryWords) {
-    json response;
-    response["query"] = query;
-    response["total"] = results.size();
+                                      const vector<string>& queryWords,
+                                      const vector<string>* summaries,
+                                      int pageSize,
+                                      unsigned fields,
+                                      bool recordMetrics) {
+    // 摘要在序列化过程中按需生成，分别计时：摘要耗时单独统计，其余计入序列化
+    auto start = std::chrono::steady_clock::now();
+    int64_t snippetUs = -1;
+    if (!summaries && (fields & FIELD_SUMMARY)) {
+        snippetUs = 0;
+    }
+
+    // 直接写入返回值（NRVO），由调用方移交给响应，全程不拷贝；按字段预估容量减少扩容
+    string response;
+    response.reserve(256 + results.size() * ((fields & FIELD_SUMMARY) ? 640 : 160));
+    JsonWriter writer(response);
+    writer.beginObject();
+    writer.key("query").value(query);
+    writer.key("total").value(results.size());
 
-    json items = json::array();
-    int count = 0;
-    for (const auto& result : results) {
-        if (count++ >= 20) break;
+    string termKey = (_snippetCache && !summaries && (fields & FIELD_SUMMARY))
+        ? snippetTermKey(queryWords) : string();
 
-        json item;
-        item["docId"] = result.first;
-        item["score"] = result.second;
+    writer.key("results").beginArray();
+    bool needPage = (fields & (FIELD_TITLE | FIELD_URL | FIELD_SUMMARY)) != 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& result = results[i];
 
+        writer.beginObject();
+        if (fields & FIELD_ID) {
+            writer.key("docId").value(result.first);
+        }
+        if (fields & FIELD_SCORE) {
+            writer.key("score").value(result.second);
+        }
+        if (!needPage) {
+            writer.endObject();
+            continue;
+        }
+
+        // 只取请求了的字段：未请求摘要时不读正文、不查摘要缓存
         if (_useLiteMode) {
             auto it = _pageMetaLib.find(result.first);
             if (it != _pageMetaLib.end()) {
                 const auto& meta = it->second;
-                item["title"] = cleanUtf8(meta.title);
-                item["url"] = cleanUtf8(meta.url);
-                item["summary"] = cleanUtf8(_contentStore->getSummary(
-                    meta.contentOffset, meta.contentLength, queryWords));
+                if (fields & FIELD_TITLE) writer.key("title").escapedValue(meta.titleJson);
+                if (fields & FIELD_URL) writer.key("url").escapedValue(meta.urlJson);
+                if (fields & FIELD_SUMMARY) {
+                    if (summaries) {
+                        writer.key("summary").value((*summaries)[i]);
+                    } else {
+                        auto snippetStart = std::chrono::steady_clock::now();
+                        string summary = lookupSummary(result.first, termKey, [&]() {
+                            return _contentStore->getSummary(meta, queryWords);
+                        });
+                        snippetUs += elapsedUs(snippetStart);
+                        writer.key("summary").value(summary);
+                    }
+                }
             } else {
-                item["title"] = "Document " + std::to_string(result.first);
-                item["url"] = "";
-                item["summary"] = "";
+                if (fields & FIELD_TITLE) writer.key("title").value("Document " + std::to_string(result.first));
+                if (fields & FIELD_URL) writer.key("url").value("");
+                if (fields & FIELD_SUMMARY) writer.key("summary").value("");
             }
         } else {
             auto it = _pageLib.find(result.first);
             if (it != _pageLib.end()) {
                 auto& page = it->second;
-                item["title"] = cleanUtf8(page->getTitle());
-                item["url"] = cleanUtf8(page->getUrl());
-                item["summary"] = cleanUtf8(page->getSummary(queryWords));
+                if (fields & FIELD_TITLE) writer.key("title").escapedValue(page->getTitleJson());
+                if (fields & FIELD_URL) writer.key("url").escapedValue(page->getUrlJson());
+                if (fields & FIELD_SUMMARY) {
+                    if (summaries) {
+                        writer.key("summary").value((*summaries)[i]);
+                    } else {
+                        auto snippetStart = std::chrono::steady_clock::now();
+                        string summary = lookupSummary(result.first, termKey, [&]() {
+                            return page->getSummary(queryWords);
+                        });
+                        snippetUs += elapsedUs(snippetStart);
+                        writer.key("summary").value(summary);
+                    }
+                }
             } else {
-                item["title"] = "Document " + std::to_string(result.first);
-                item["url"] = "";
-                item["summary"] = "";
+                if (fields & FIELD_TITLE) writer.key("title").value("Document " + std::to_string(result.first));
+                if (fields & FIELD_URL) writer.key("url").value("");
+                if (fields & FIELD_SUMMARY) writer.key("summary").value("");
             }
         }
 
-        items.push_back(item);
+        writer.endObject();
+    }
+    writer.endArray();
+    // 满页时给出下一页游标
+    if (pageSize > 0 && results.size() >= (size_t)pageSize) {
+        writer.key("next_cursor").value(encodeCursor(results.back()));
     }
+    writer.endObject();
 
-    response["results"] = items;
-    return response.dump();
+    if (!recordMetrics) {
+        return response;
+    }
+    int64_t totalUs = elapsedUs(start);
+    if (snippetUs >= 0) {
+        Metrics::getInstance()->record(STAGE_SNIPPET, snippetUs);
+        totalUs -= snippetUs;
+    }
+    Metrics::getInstance()->record(STAGE_SERIALIZE, totalUs);
+    return response;
 }
 
 string SearchServer::generateSuggestResponse(const string& query,
                                              const vector<string>& suggestions) {
-    json response;
-    response["query"] = query;
-
-    json suggestionList = json::array();
+    string response;
+    JsonWriter writer(response);
+    writer.beginObject();
+    writer.key("query").value(query);
+    writer.key("suggestions").beginArray();
     for (const auto& s : suggestions) {
-        suggestionList.push_back(s);
+        writer.value(s);
     }
-    response["suggestions"] = suggestionList;
-
-    return response.dump();
+    writer.endArray();
+    writer.endObject();
+    return response;
 }
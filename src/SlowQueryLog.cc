@@ -0,0 +1,169 @@
+#include "SlowQueryLog.h"
+#include "JsonWriter.h"
+#include "Logger.h"
+#include <fstream>
+#include <algorithm>
+#include <functional>
+#include <cstdio>
+#include <chrono>
+#include <ctime>
+#include <cmath>
+
+SlowQueryLog::SlowQueryLog(const string& logPath, int64_t thresholdUs, double sampleRate, size_t capacity)
+    : _logPath(logPath)
+    , _thresholdUs(thresholdUs)
+    , _ring(std::max(capacity, (size_t)1)) {
+    sampleRate = std::min(std::max(sampleRate, 0.0), 1.0);
+    _sampleThreshold = (uint32_t)std::min(std::ldexp(sampleRate, 32), 4294967295.0);
+
+    if (!_logPath.empty()) {
+        _writer = std::thread(&SlowQueryLog::writerLoop, this);
+    }
+    LOG_INFO("Slow query log enabled: threshold " + std::to_string(thresholdUs / 1000) + "ms, sample rate "
+             + std::to_string(sampleRate) + ", keep " + std::to_string(_ring.size()) + " entries");
+}
+
+SlowQueryLog::~SlowQueryLog() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _cv.notify_one();
+    if (_writer.joinable()) {
+        _writer.join();
+    }
+}
+
+bool SlowQueryLog::sample() const {
+    if (_sampleThreshold == 0) {
+        return false;
+    }
+    // xorshift32，线程私有，无需同步
+    thread_local uint32_t state = (uint32_t)std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state < _sampleThreshold;
+}
+
+void SlowQueryLog::record(const SlowQueryRecord& rec) {
+    string line = serialize(rec);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_logPath.empty()) {
+        if (_pending.size() < MAX_PENDING) {
+            _pending.push_back(line);
+            _cv.notify_one();
+        } else {
+            _dropped++;
+        }
+    }
+    _ring[_next] = std::move(line);
+    _next = (_next + 1) % _ring.size();
+    _recorded++;
+}
+
+void SlowQueryLog::render(string& out) {
+    JsonWriter writer(out);
+    writer.beginObject();
+    writer.key("threshold_ms").value((double)_thresholdUs / 1000);
+    writer.key("sample_rate").value(std::ldexp((double)_sampleThreshold, -32));
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    writer.key("recorded").value((size_t)_recorded);
+    writer.key("dropped").value((size_t)_dropped);
+    writer.key("entries").beginArray();
+    for (size_t i = 1; i <= _ring.size(); ++i) {
+        const string& entry = _ring[(_next + _ring.size() - i) % _ring.size()];
+        if (entry.empty()) break;
+        writer.raw(entry);
+    }
+    writer.endArray();
+    writer.endObject();
+}
+
+string SlowQueryLog::serialize(const SlowQueryRecord& rec) {
+    static const char* traceNames[TRACE_COUNT] = {
+        "dequeued", "tokenized", "retrieved", "snippets_read", "serialized"
+    };
+
+    auto now = std::chrono::system_clock::now();
+    time_t seconds = std::chrono::system_clock::to_time_t(now);
+    int millis = (int)(std::chrono::duration_cast<std::chrono::milliseconds>(
+        now.time_since_epoch()).count() % 1000);
+    struct tm local;
+    localtime_r(&seconds, &local);
+    char timeBuf[32];
+    size_t len = strftime(timeBuf, sizeof(timeBuf), "%Y-%m-%d %H:%M:%S", &local);
+    snprintf(timeBuf + len, sizeof(timeBuf) - len, ".%03d", millis);
+
+    string out;
+    JsonWriter writer(out);
+    writer.beginObject();
+    writer.key("time").value(timeBuf);
+    writer.key("query").value(rec.query);
+    writer.key("reason").value(rec.sampled ? "sample" : "slow");
+    writer.key("total_us").value(rec.totalUs);
+    writer.key("from").value(rec.from);
+    writer.key("size").value(rec.size);
+    writer.key("fields").value((int)rec.fields);
+    writer.key("degraded").value(rec.degraded);
+    writer.key("results").value(rec.results);
+
+    writer.key("trace_us").beginObject();
+    for (int i = 0; i < TRACE_COUNT; ++i) {
+        if (rec.trace[i] >= 0) {
+            writer.key(traceNames[i]).value(rec.trace[i]);
+        }
+    }
+    writer.endObject();
+
+    if (!rec.stats.path.empty()) {
+        writer.key("retrieval").beginObject();
+        writer.key("path").value(rec.stats.path);
+        writer.key("fallback").value(rec.stats.fallback);
+        writer.key("postings_scored").value(rec.stats.postingsScored);
+        writer.key("docs_touched").value(rec.stats.docsTouched);
+        writer.key("terms").beginArray();
+        for (const auto& term : rec.stats.terms) {
+            writer.beginObject();
+            writer.key("term").value(term.term);
+            writer.key("postings").value(term.postings);
+            writer.key("max_impact").value(term.maxImpact);
+            writer.key("hot").value(term.hot);
+            writer.endObject();
+        }
+        writer.endArray();
+        writer.endObject();
+    }
+    writer.endObject();
+    return out;
+}
+
+void SlowQueryLog::writerLoop() {
+    std::ofstream ofs(_logPath, std::ios::app);
+    if (!ofs) {
+        LOG_WARN("Cannot open slow query log: " + _logPath + ", keeping entries in memory only");
+    }
+
+    vector<string> batch;
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _cv.wait(lock, [this] { return _stopping || !_pending.empty(); });
+        if (_pending.empty() && _stopping) {
+            break;
+        }
+        batch.swap(_pending);
+        lock.unlock();
+
+        if (ofs) {
+            for (const auto& line : batch) {
+                ofs << line << '\n';
+            }
+            ofs.flush();
+        }
+        batch.clear();
+
+        lock.lock();
+    }
+}
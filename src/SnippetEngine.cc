@@ -0,0 +1,214 @@
+#include "SnippetEngine.h"
+#include <algorithm>
+#include <cstring>
+
+// UTF-8 首字节对应的字符字节数
+static inline size_t utf8CharLen(unsigned char c) {
+    if ((c & 0x80) == 0) return 1;
+    if ((c & 0xE0) == 0xC0) return 2;
+    if ((c & 0xF0) == 0xE0) return 3;
+    if ((c & 0xF8) == 0xF0) return 4;
+    return 1;
+}
+
+// 判断 pos 处是否为句末标点，是则返回标点字节数
+static inline size_t sentenceEndAt(string_view text, size_t pos) {
+    unsigned char c = text[pos];
+    if (c == '\n' || c == '!' || c == '?' || c == ';') return 1;
+    if (c == '.') {
+        // 英文句号后需跟空白，避免切开网址和小数
+        return (pos + 1 == text.size() || text[pos + 1] == ' ' || text[pos + 1] == '\n') ? 1 : 0;
+    }
+    if (c == 0xE3 && pos + 2 < text.size() &&
+        (unsigned char)text[pos + 1] == 0x80 && (unsigned char)text[pos + 2] == 0x82) {
+        return 3;  // 。
+    }
+    if (c == 0xEF && pos + 2 < text.size() && (unsigned char)text[pos + 1] == 0xBC) {
+        unsigned char c2 = text[pos + 2];
+        if (c2 == 0x81 || c2 == 0x9F || c2 == 0x9B) return 3;  // ！ ？ ；
+    }
+    return 0;
+}
+
+string_view SnippetEngine::truncateUtf8(string_view text, size_t maxBytes) {
+    if (text.size() <= maxBytes) return text;
+    size_t end = maxBytes;
+    // 回退到字符起始字节，丢弃被截断的半个字符
+    while (end > 0 && ((unsigned char)text[end] & 0xC0) == 0x80) {
+        --end;
+    }
+    return text.substr(0, end);
+}
+
+vector<uint32_t> SnippetEngine::segment(string_view text) {
+    text = truncateUtf8(text, SCAN_BYTES);
+
+    vector<uint32_t> ends;
+    for (size_t i = 0; i < text.size(); ) {
+        size_t punct = sentenceEndAt(text, i);
+        if (punct > 0) {
+            i += punct;
+            ends.push_back((uint32_t)i);
+        } else {
+            i += utf8CharLen(text[i]);
+        }
+    }
+    if (ends.empty() || ends.back() < text.size()) {
+        ends.push_back((uint32_t)text.size());
+    }
+    return ends;
+}
+
+// HTML 转义追加
+static void appendEscaped(string& out, string_view s) {
+    for (char c : s) {
+        switch (c) {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            default: out += c;
+        }
+    }
+}
+
+string SnippetEngine::bestWindow(string_view text, const uint32_t* ends, size_t count,
+                                 const vector<string>& queryWords, size_t maxChars) {
+    text = truncateUtf8(text, SCAN_BYTES);
+    if (text.empty()) return "";
+
+    // 1. 句子边界：裁剪预计算结果到当前文本范围
+    vector<uint32_t> sentEnds;
+    if (ends && count > 0) {
+        sentEnds.reserve(count + 1);
+        for (size_t i = 0; i < count && ends[i] < text.size(); ++i) {
+            if (ends[i] > 0) sentEnds.push_back(ends[i]);
+        }
+        sentEnds.push_back((uint32_t)text.size());
+    } else {
+        sentEnds = segment(text);
+    }
+    size_t sentCount = sentEnds.size();
+
+    // 2. 查询词去重，按长度降序保证优先匹配较长的词（最多 64 个，用位掩码表示覆盖）
+    vector<string_view> terms;
+    for (const auto& w : queryWords) {
+        if (!w.empty() && w != " ") terms.push_back(w);
+    }
+    std::sort(terms.begin(), terms.end(), [](string_view a, string_view b) {
+        return a.size() != b.size() ? a.size() > b.size() : a < b;
+    });
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+    if (terms.size() > 64) terms.resize(64);
+
+    bool firstByte[256] = {false};
+    for (auto t : terms) firstByte[(unsigned char)t[0]] = true;
+
+    // 3. 单次扫描：统计每个句子的字符数、命中词集合与命中次数，并记录命中位置用于高亮
+    struct Hit { uint32_t pos; uint32_t len; };
+    vector<Hit> hits;
+    vector<uint64_t> sentMask(sentCount, 0);
+    vector<uint32_t> sentHits(sentCount, 0);
+    vector<uint32_t> sentChars(sentCount, 0);
+
+    size_t cur = 0;
+    for (size_t i = 0; i < text.size(); ) {
+        while (cur + 1 < sentCount && i >= sentEnds[cur]) ++cur;
+
+        size_t step = utf8CharLen(text[i]);
+        size_t chars = 1;
+        if (firstByte[(unsigned char)text[i]]) {
+            for (size_t k = 0; k < terms.size(); ++k) {
+                auto t = terms[k];
+                if (t.size() <= text.size() - i && memcmp(text.data() + i, t.data(), t.size()) == 0) {
+                    hits.push_back({(uint32_t)i, (uint32_t)t.size()});
+                    sentMask[cur] |= (1ULL << k);
+                    sentHits[cur]++;
+                    // 命中词整体跳过，按其字符数计数
+                    chars = 0;
+                    for (size_t p = 0; p < t.size(); p += utf8CharLen(t[p])) ++chars;
+                    step = t.size();
+                    break;
+                }
+            }
+        }
+        sentChars[cur] += chars;
+        i += step;
+    }
+
+    // 4. 滑动窗口：连续句子总字符数不超过 maxChars，按（覆盖的不同查询词数，命中次数）取最优，同分取靠前者
+    size_t bestStart = 0, bestEnd = 1;
+    int bestCover = -1;
+    uint32_t bestHits = 0;
+    for (size_t s = 0; s < sentCount; ++s) {
+        uint64_t mask = 0;
+        uint32_t hitCount = 0;
+        size_t charsTotal = 0;
+        size_t e = s;
+        while (e < sentCount && (e == s || charsTotal + sentChars[e] <= maxChars)) {
+            mask |= sentMask[e];
+            hitCount += sentHits[e];
+            charsTotal += sentChars[e];
+            ++e;
+        }
+        int cover = __builtin_popcountll(mask);
+        if (cover > bestCover || (cover == bestCover && hitCount > bestHits)) {
+            bestCover = cover;
+            bestHits = hitCount;
+            bestStart = s;
+            bestEnd = e;
+        }
+    }
+
+    size_t start = bestStart == 0 ? 0 : sentEnds[bestStart - 1];
+    size_t windowEnd = sentEnds[bestEnd - 1];
+
+    // 跳过句首空白
+    while (start < windowEnd && (text[start] == ' ' || text[start] == '\n' || text[start] == '\r' || text[start] == '\t')) {
+        ++start;
+    }
+
+    // 单个长句超过 maxChars 时，从首个命中词前 30 个字符处开始
+    auto firstHit = std::lower_bound(hits.begin(), hits.end(), (uint32_t)start,
+                                     [](const Hit& h, uint32_t pos) { return h.pos < pos; });
+    if (firstHit != hits.end() && firstHit->pos < windowEnd) {
+        size_t charsBefore = 0;
+        for (size_t p = start; p < firstHit->pos; p += utf8CharLen(text[p])) ++charsBefore;
+        if (charsBefore > maxChars / 2) {
+            size_t back = firstHit->pos;
+            for (int n = 0; n < 30 && back > start; ++n) {
+                do { --back; } while (back > start && ((unsigned char)text[back] & 0xC0) == 0x80);
+            }
+            start = back;
+            firstHit = std::lower_bound(hits.begin(), hits.end(), (uint32_t)start,
+                                        [](const Hit& h, uint32_t pos) { return h.pos < pos; });
+        }
+    }
+
+    // 5. 输出 maxChars 个字符，命中词加 <em> 高亮
+    string summary;
+    summary.reserve(maxChars * 4);
+    if (start > 0) summary += "...";
+
+    size_t charCount = 0;
+    size_t pos = start;
+    auto hit = firstHit;
+    while (pos < text.size() && charCount < maxChars) {
+        if (hit != hits.end() && hit->pos == pos) {
+            summary += "<em>";
+            appendEscaped(summary, text.substr(pos, hit->len));
+            summary += "</em>";
+            for (size_t p = pos; p < pos + hit->len; p += utf8CharLen(text[p])) ++charCount;
+            pos += hit->len;
+            ++hit;
+            continue;
+        }
+        size_t len = utf8CharLen(text[pos]);
+        if (pos + len > text.size()) break;
+        appendEscaped(summary, text.substr(pos, len));
+        pos += len;
+        charCount++;
+    }
+    if (pos < text.size()) summary += "...";
+
+    return summary;
+}
@@ -0,0 +1,186 @@
+#include "TermCache.h"
+#include <algorithm>
+#include <functional>
+
+using std::make_shared;
+
+double HotTermEntry::lookup(int docId) const {
+    auto it = std::lower_bound(byDoc.begin(), byDoc.end(), docId,
+                               [](const pair<int, double>& item, int id) {
+                                   return item.first < id;
+                               });
+    if (it != byDoc.end() && it->first == docId) {
+        return it->second;
+    }
+    return 0;
+}
+
+FrequencySketch::FrequencySketch(size_t width)
+    : _width(std::max(width, (size_t)64))
+    , _counters(new std::atomic<uint32_t>[DEPTH * _width]) {
+    for (size_t i = 0; i < DEPTH * _width; ++i) {
+        _counters[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+uint32_t FrequencySketch::increment(const string& key) {
+    uint64_t h = std::hash<string>{}(key);
+    uint32_t h1 = (uint32_t)h;
+    uint32_t h2 = (uint32_t)(h >> 32) | 1;
+
+    uint32_t estimate = UINT32_MAX;
+    for (int i = 0; i < DEPTH; ++i) {
+        size_t slot = i * _width + (h1 + i * h2) % _width;
+        uint32_t v = _counters[slot].fetch_add(1, std::memory_order_relaxed) + 1;
+        estimate = std::min(estimate, v);
+    }
+
+    // 每累计 10 * width 次计数衰减一次
+    if (_additions.fetch_add(1, std::memory_order_relaxed) + 1 >= _width * 10) {
+        age();
+    }
+    return estimate;
+}
+
+void FrequencySketch::age() {
+    _additions.store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < DEPTH * _width; ++i) {
+        _counters[i].store(_counters[i].load(std::memory_order_relaxed) >> 1,
+                           std::memory_order_relaxed);
+    }
+}
+
+HotTermCache::HotTermCache(size_t termCapacity, size_t pairCapacity,
+                           uint32_t admitThreshold,
+                           size_t prefixLen,
+                           size_t minPostings)
+    : _terms(termCapacity)
+    , _pairs(std::max(pairCapacity, (size_t)1))
+    , _pairsEnabled(pairCapacity > 0)
+    , _admitThreshold(admitThreshold)
+    , _prefixLen(std::max(prefixLen, (size_t)1))
+    , _minPostings(minPostings) {
+}
+
+shared_ptr<const HotTermEntry> HotTermCache::acquireTerm(const string& term,
+                                                         const vector<InvertIndexItem>& postings,
+                                                         bool admit) {
+    // 短倒排表完整遍历本身就很便宜，不值得占用缓存
+    if (postings.size() < _minPostings) {
+        return nullptr;
+    }
+
+    shared_ptr<const HotTermEntry> entry;
+    if (!admit) {
+        _terms.peek(term, entry);
+        return entry;
+    }
+    if (_terms.get(term, entry)) {
+        _terms.recordQuery(true);
+        return entry;
+    }
+    _terms.recordQuery(false);
+
+    if (_sketch.increment(term) < _admitThreshold) {
+        return nullptr;
+    }
+
+    entry = buildTerm(postings);
+    _terms.put(term, entry);
+    return entry;
+}
+
+shared_ptr<const HotPairEntry> HotTermCache::acquirePair(const string& a, const HotTermEntry& entryA,
+                                                         const string& b, const HotTermEntry& entryB,
+                                                         bool admit) {
+    if (!_pairsEnabled) {
+        return nullptr;
+    }
+
+    // 词对无序：统一按字典序拼接键
+    string key = a < b ? a + '\x1f' + b : b + '\x1f' + a;
+
+    shared_ptr<const HotPairEntry> entry;
+    if (!admit) {
+        _pairs.peek(key, entry);
+        return entry;
+    }
+    if (_pairs.get(key, entry)) {
+        _pairs.recordQuery(true);
+        return entry;
+    }
+    _pairs.recordQuery(false);
+
+    if (_sketch.increment(key) < _admitThreshold) {
+        return nullptr;
+    }
+
+    entry = buildPair(entryA, entryB);
+    _pairs.put(key, entry);
+    return entry;
+}
+
+shared_ptr<const HotTermEntry> HotTermCache::buildTerm(const vector<InvertIndexItem>& postings) const {
+    auto entry = make_shared<HotTermEntry>();
+
+    // 倒排表在构建阶段已按权重降序排列，前缀直接截取即可
+    size_t n = std::min(_prefixLen, postings.size());
+    entry->prefix.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        entry->prefix.emplace_back(postings[i].docId, postings[i].weight);
+    }
+    entry->tailBound = n < postings.size() ? postings[n].weight : 0;
+
+    entry->byDoc.reserve(postings.size());
+    for (const auto& item : postings) {
+        entry->byDoc.emplace_back(item.docId, item.weight);
+    }
+    std::sort(entry->byDoc.begin(), entry->byDoc.end());
+
+    return entry;
+}
+
+shared_ptr<const HotPairEntry> HotTermCache::buildPair(const HotTermEntry& a, const HotTermEntry& b) const {
+    auto entry = make_shared<HotPairEntry>();
+
+    // 两条 docId 有序表归并求交
+    auto ia = a.byDoc.begin();
+    auto ib = b.byDoc.begin();
+    while (ia != a.byDoc.end() && ib != b.byDoc.end()) {
+        if (ia->first < ib->first) {
+            ++ia;
+        } else if (ib->first < ia->first) {
+            ++ib;
+        } else {
+            entry->top.emplace_back(ia->first, ia->second + ib->second);
+            ++ia;
+            ++ib;
+        }
+    }
+
+    auto byScore = [](const pair<int, double>& x, const pair<int, double>& y) {
+        return x.second > y.second;
+    };
+    if (entry->top.size() > _prefixLen) {
+        std::partial_sort(entry->top.begin(), entry->top.begin() + _prefixLen,
+                          entry->top.end(), byScore);
+        entry->top.resize(_prefixLen);
+    } else {
+        std::sort(entry->top.begin(), entry->top.end(), byScore);
+    }
+    entry->top.shrink_to_fit();
+
+    return entry;
+}
+
+size_t HotTermCache::memoryUsage() {
+    // 条目由 make_shared 分配，控制块与对象在同一块内存中
+    size_t bytes = _terms.memoryUsage([](const shared_ptr<const HotTermEntry>& entry) {
+        return mallocBytes(sizeof(HotTermEntry) + 16) + vectorHeapBytes(entry->prefix)
+            + vectorHeapBytes(entry->byDoc);
+    });
+    bytes += _pairs.memoryUsage([](const shared_ptr<const HotPairEntry>& entry) {
+        return mallocBytes(sizeof(HotPairEntry) + 16) + vectorHeapBytes(entry->top);
+    });
+    return bytes + _sketch.memoryUsage();
+}
@@ -1,165 +1,204 @@
-#include "WebPage.h"
-#include "SplitTool.h"
-#include <regex>
-#include <algorithm>
-#include <functional>
-
-using std::regex;
-using std::regex_search;
-using std::smatch;
-
-int WebPage::_idGen = 0;
-
-WebPage::WebPage(const string& doc, SplitTool* splitTool)
-    : _docId(++_idGen)
-    , _splitTool(splitTool) {
-    processDoc(doc);
-}
-
-void WebPage::processDoc(const string& doc) {
-    // 解析 XML 格式的文档
-    // <doc>
-    //   <docid>1</docid>
-    //   <title>标题</title>
-    //   <url>http://...</url>
-    //   <content>内容</content>
-    // </doc>
-
-    smatch match;
-
-    // 提取标题 - 兼容 <title> 和 <contenttitle> 标签
-    static const regex titleRegex("<(?:content)?title>([\\s\\S]*?)</(?:content)?title>");
-    //              源文件 结果存放   提取的标识
-    if (regex_search(doc, match, titleRegex)) {
-        _title = match[1].str();
-    }
-
-    // 提取 URL
-    static const regex urlRegex("<url>([\\s\\S]*?)</url>");
-    if (regex_search(doc, match, urlRegex)) {
-        _url = match[1].str();
-    }
-
-    // 提取内容
-    static const regex contentRegex("<content>([\\s\\S]*?)</content>");
-    if (regex_search(doc, match, contentRegex)) {
-        _content = match[1].str();
-    }
-
-    // 如果没有 XML 标签，直接使用原文
-    if (_title.empty() && _content.empty()) {
-        _content = doc;
-        _title = doc.substr(0, std::min((size_t)50, doc.length()));
-    }
-
-    // 分词并统计词频
-    string text = _title + " " + _content;
-    vector<string> words = _splitTool->cut(text);
-
-    for (const auto& word : words) {
-        _wordsMap[word]++;
-    }
-}
-
-// Jenkins hash 函数（用于 SimHash）
-static uint64_t jenkinsHash(const string& key) {
-    uint64_t hash = 0;
-    for (size_t i = 0; i < key.length(); ++i) {
-        hash += static_cast<uint8_t>(key[i]);
-        hash += (hash << 10);
-        hash ^= (hash >> 6);
-    }
-    hash += (hash << 3);
-    hash ^= (hash >> 11);
-    hash += (hash << 15);
-    return hash;
-}
-
-uint64_t WebPage::getSimhash() const {
-    // 真正的 SimHash 实现
-    // 1. 对每个词计算64位hash
-    // 2. 根据词频作为权重，对每一位进行加权统计
-    // 3. 每一位权重和大于0则该位为1，否则为0
-
-    // 64位的权重数组
-    double weights[64] = {0};
-
-    for (const auto& pair : _wordsMap) {
-        const string& word = pair.first;
-        int freq = pair.second;  // 词频作为权重
-
-        // 计算词的64位hash
-        uint64_t wordHash = jenkinsHash(word);
-
-        // 对每一位进行加权
-        for (int i = 0; i < 64; ++i) {
-            if ((wordHash >> i) & 1) {
-                weights[i] += freq;  // 该位为1，加权重
-            } else {
-                weights[i] -= freq;  // 该位为0，减权重
-            }
-        }
-    }
-
-    // 根据权重生成最终的 SimHash
-    uint64_t simhash = 0;
-    for (int i = 0; i < 64; ++i) {
-        if (weights[i] > 0) {
-            simhash |= (1ULL << i);
-        }
-    }
-
-    return simhash;
-}
-
-// 计算汉明距离
-int WebPage::hammingDistance(uint64_t h1, uint64_t h2) {
-    uint64_t x = h1 ^ h2;
-    int count = 0;
-    while (x) {
-        count += x & 1;
-        x >>= 1;
-    }
-    return count;
-}
-
-
-
-
- string WebPage::getSummary(const vector<string>& queryWords) const {
-      if (_content.empty()) return "";
-
-      size_t maxChars = 150;
-      string text = _content;
-      size_t start = 0;
-//在文档里面找匹配第一个查询词的结果，前30共150个字符
-      for (const auto& word : queryWords) {
-          size_t pos = text.find(word);
-          if (pos != string::npos && pos > 30) {
-              start = pos - 30;
-              break;
-          }
-      }
-
-      size_t charCount = 0;
-      size_t endPos = start;
-
-      while (endPos < text.length() && charCount < maxChars) {
-          unsigned char c = text[endPos];
-          size_t charLen = 1;
-          if ((c & 0x80) == 0) charLen = 1;
-          else if ((c & 0xE0) == 0xC0) charLen = 2;
-          else if ((c & 0xF0) == 0xE0) charLen = 3;
-          else if ((c & 0xF8) == 0xF0) charLen = 4;
-
-          if (endPos + charLen > text.length()) break;
-          endPos += charLen;
-          charCount++;
-      }
-
-      string summary = text.substr(start, endPos - start);
-      if (start > 0) summary = "..." + summary;
-      if (endPos < text.length()) summary += "...";
-
-      return summary;
- }
+#include "WebPage.h"
+#include "SplitTool.h"
+#include "SnippetEngine.h"
+#include "JsonWriter.h"
+#include "MemoryUsage.h"
+#include "BuildProfiler.h"
+#include <algorithm>
+#include <functional>
+#include <cstring>
+
+int WebPage::_idGen = 0;
+
+WebPage::WebPage(string_view doc, SplitTool* splitTool)
+    : _docId(++_idGen)
+    , _splitTool(splitTool) {
+    processDoc(doc);
+}
+
+// 各字段的起止标签；第二种写法为空表示只有一种
+struct FieldTags {
+    string_view open[2];
+    string_view close[2];
+};
+
+static const FieldTags TITLE_TAGS = {{"<title>", "<contenttitle>"}, {"</title>", "</contenttitle>"}};
+static const FieldTags URL_TAGS = {{"<url>", ""}, {"</url>", ""}};
+static const FieldTags CONTENT_TAGS = {{"<content>", ""}, {"</content>", ""}};
+
+// text 是否以 tags 中某个标签开头，返回该标签长度，都不匹配返回 0
+static size_t matchTag(string_view text, const string_view (&tags)[2]) {
+    for (const auto& tag : tags) {
+        if (!tag.empty() && text.size() >= tag.size()
+            && memcmp(text.data(), tag.data(), tag.size()) == 0) {
+            return tag.size();
+        }
+    }
+    return 0;
+}
+
+WebPage::DocFields WebPage::extractFields(string_view doc) {
+    // 只在 '<' 处检查标签，memchr 跳过其间的正文；三个字段各自独立匹配，
+    // 与原来的三个正则 <(?:content)?title>([\s\S]*?)</(?:content)?title> 等逐字节等价：
+    // 取最早出现的起始标签，再取其后最早出现的结束标签（两种写法可以混用），没有结束标签则字段为空
+    struct Scan {
+        const FieldTags* tags;
+        string_view* out;
+        size_t begin;
+        bool done;
+    };
+    DocFields fields;
+    Scan scans[] = {
+        {&TITLE_TAGS, &fields.title, string_view::npos, false},
+        {&URL_TAGS, &fields.url, string_view::npos, false},
+        {&CONTENT_TAGS, &fields.content, string_view::npos, false},
+    };
+    int pending = 3;
+
+    const char* base = doc.data();
+    size_t size = doc.size();
+    size_t pos = 0;
+    while (pending > 0 && pos < size) {
+        const char* found = static_cast<const char*>(memchr(base + pos, '<', size - pos));
+        if (!found) {
+            break;
+        }
+        pos = found - base;
+        string_view rest = doc.substr(pos);
+        for (auto& scan : scans) {
+            if (scan.done) {
+                continue;
+            }
+            if (scan.begin == string_view::npos) {
+                size_t len = matchTag(rest, scan.tags->open);
+                if (len > 0) {
+                    scan.begin = pos + len;
+                }
+            } else if (matchTag(rest, scan.tags->close) > 0) {
+                *scan.out = doc.substr(scan.begin, pos - scan.begin);
+                scan.done = true;
+                pending--;
+            }
+        }
+        pos++;
+    }
+    return fields;
+}
+
+void WebPage::processDoc(string_view doc) {
+    // 解析 XML 格式的文档
+    // <doc>
+    //   <docid>1</docid>
+    //   <title>标题</title>          也可以是 <contenttitle>
+    //   <url>http://...</url>
+    //   <content>内容</content>
+    // </doc>
+
+    PhaseTimer extractTimer(PHASE_EXTRACT);
+    DocFields fields = extractFields(doc);
+    _title.assign(fields.title.data(), fields.title.size());
+    _url.assign(fields.url.data(), fields.url.size());
+    _content.assign(fields.content.data(), fields.content.size());
+
+    // 如果没有 XML 标签，直接使用原文
+    if (_title.empty() && _content.empty()) {
+        _content.assign(doc.data(), doc.size());
+        _title.assign(doc.data(), std::min((size_t)50, doc.size()));
+    }
+
+    // 标题和 URL 加载后不再变化，预先转义，查询时直接拼接
+    JsonWriter::escape(_titleJson, _title);
+    JsonWriter::escape(_urlJson, _url);
+    extractTimer.stop();
+
+    PhaseTimer tokenizeTimer(PHASE_TOKENIZE);
+    // 预先分句，查询时直接按句子边界选取摘要窗口
+    _sentenceEnds = SnippetEngine::segment(_content);
+
+    // 分词并统计词频
+    string text = _title + " " + _content;
+    vector<string> words = _splitTool->cut(text);
+
+    for (const auto& word : words) {
+        _wordsMap[word]++;
+    }
+}
+
+// Jenkins hash 函数（用于 SimHash）
+static uint64_t jenkinsHash(const string& key) {
+    uint64_t hash = 0;
+    for (size_t i = 0; i < key.length(); ++i) {
+        hash += static_cast<uint8_t>(key[i]);
+        hash += (hash << 10);
+        hash ^= (hash >> 6);
+    }
+    hash += (hash << 3);
+    hash ^= (hash >> 11);
+    hash += (hash << 15);
+    return hash;
+}
+
+uint64_t WebPage::getSimhash() const {
+    // 真正的 SimHash 实现
+    // 1. 对每个词计算64位hash
+    // 2. 根据词频作为权重，对每一位进行加权统计
+    // 3. 每一位权重和大于0则该位为1，否则为0
+
+    // 64位的权重数组
+    double weights[64] = {0};
+
+    for (const auto& pair : _wordsMap) {
+        const string& word = pair.first;
+        int freq = pair.second;  // 词频作为权重
+
+        // 计算词的64位hash
+        uint64_t wordHash = jenkinsHash(word);
+
+        // 对每一位进行加权
+        for (int i = 0; i < 64; ++i) {
+            if ((wordHash >> i) & 1) {
+                weights[i] += freq;  // 该位为1，加权重
+            } else {
+                weights[i] -= freq;  // 该位为0，减权重
+            }
+        }
+    }
+
+    // 根据权重生成最终的 SimHash
+    uint64_t simhash = 0;
+    for (int i = 0; i < 64; ++i) {
+        if (weights[i] > 0) {
+            simhash |= (1ULL << i);
+        }
+    }
+
+    return simhash;
+}
+
+// 计算汉明距离
+int WebPage::hammingDistance(uint64_t h1, uint64_t h2) {
+    uint64_t x = h1 ^ h2;
+    int count = 0;
+    while (x) {
+        count += x & 1;
+        x >>= 1;
+    }
+    return count;
+}
+
+string WebPage::getSummary(const vector<string>& queryWords) const {
+    if (_content.empty()) return "";
+
+    return SnippetEngine::bestWindow(_content, _sentenceEnds.data(), _sentenceEnds.size(),
+                                     queryWords);
+}
+
+size_t WebPage::memoryUsage() const {
+    size_t bytes = heapBytes(_title) + heapBytes(_url) + heapBytes(_content)
+        + heapBytes(_titleJson) + heapBytes(_urlJson) + vectorHeapBytes(_sentenceEnds);
+    bytes += _wordsMap.size() * treeNodeBytes<map<string, int>::value_type>();
+    for (const auto& word : _wordsMap) {
+        bytes += heapBytes(word.first);
+    }
+    return bytes;
+}
@@ -7,23 +7,43 @@
 #include "WebPage.h"
 #include "DictProducer.h"
 #include "KeywordRecommender.h"
+#include "CorpusGenerator.h"
+#include "LoadGenerator.h"
+#include "BuildProfiler.h"
+#include "RankingComparator.h"
 #include "Logger.h"
 #include <memory>
 #include <csignal>
 #include <atomic>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <unordered_set>
 
 using std::make_shared;
 
-// 全局变量用于信号处理
-static std::atomic<bool> g_running{true};
-static SearchServer* g_server = nullptr;
+// 收到的退出信号（0 表示没有）；lock-free 原子变量，可在信号处理函数中写入
+static std::atomic<int> g_signal{0};
 
-// 信号处理函数
+// 信号处理函数：只记录信号编号。写日志、通知服务停止都不是异步信号安全的，由 watchSignals 在普通线程中完成
 void signalHandler(int signum) {
-    LOG_INFO("Received signal " + std::to_string(signum) + ", shutting down gracefully...");
-    g_running = false;
-    if (g_server) {
-        g_server->stop();
+    g_signal.store(signum, std::memory_order_relaxed);
+}
+
+// 服务运行期间轮询信号标志，收到退出信号后写日志并停止服务
+// 信号可能早于服务进入运行状态到达（此时 stop 不生效），因此一直重试到 start 返回
+static void watchSignals(SearchServer* server, const std::atomic<bool>* done) {
+    bool logged = false;
+    while (!done->load()) {
+        int signum = g_signal.load(std::memory_order_relaxed);
+        if (signum != 0) {
+            if (!logged) {
+                LOG_INFO("Received signal " + std::to_string(signum) + ", shutting down gracefully...");
+                logged = true;
+            }
+            server->stop();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 }
 
@@ -32,6 +52,9 @@ void printUsage(const char* progName) {
     LOG_INFO("  " + string(progName) + " build       - Build index from data");
     LOG_INFO("  " + string(progName) + " server      - Start search server (traditional mode)");
     LOG_INFO("  " + string(progName) + " server-lite - Start search server (memory-optimized mode)");
+    LOG_INFO("  " + string(progName) + " gen-corpus [docs] [corpus_path] [query_log_path] - Generate synthetic corpus");
+    LOG_INFO("  " + string(progName) + " bench-server [query_log] [rate] [concurrency] - Replay query log against a running server");
+    LOG_INFO("  " + string(progName) + " compare-index [index_a] [index_b|termcache] [query_log] - Compare rankings of two indexes");
 }
 
 int main(int argc, char* argv[]) {
@@ -54,6 +77,59 @@ int main(int argc, char* argv[]) {
         Configuration* config = Configuration::getInstance();
         config->load("conf/search.conf");
 
+        // 生成合成语料：不需要分词词典，在初始化分词工具之前处理
+        if (mode == "gen-corpus") {
+            CorpusOptions options;
+            options.docs = argc > 2 ? std::stoul(argv[2]) : config->getSize("corpus_docs", options.docs);
+            options.vocabSize = config->getSize("corpus_vocab_size", options.vocabSize);
+            options.zipfExponent = config->getDouble("corpus_zipf_exponent", options.zipfExponent);
+            options.duplicateRate = config->getDouble("corpus_duplicate_rate", options.duplicateRate);
+            options.queries = config->getSize("corpus_queries", options.queries);
+            options.seed = config->getSize("corpus_seed", options.seed);
+            options.vocabPath = config->get("corpus_vocab_path");
+            string corpusPath = argc > 3 ? argv[3] : config->get("corpus_path", "./data/synthetic_corpus.xml");
+            string queryLogPath = argc > 4 ? argv[4] : config->get("corpus_query_log_path", "./data/synthetic_queries.txt");
+
+            LOG_INFO("=== Generating Synthetic Corpus ===");
+            CorpusGenerator generator(options);
+            generator.writeCorpus(corpusPath);
+            generator.writeQueryLog(queryLogPath);
+            return 0;
+        }
+
+        // 查询日志回放压测：只作为 HTTP 客户端，同样不需要分词词典
+        if (mode == "bench-server") {
+            LoadOptions options;
+            options.host = config->get("bench_host", config->get("server_ip", "127.0.0.1"));
+            if (options.host == "0.0.0.0") {
+                options.host = "127.0.0.1";
+            }
+            options.port = config->getInt("bench_port", config->getInt("server_port", options.port));
+            options.path = config->get("bench_path", "/search");
+            options.rate = argc > 3 ? std::stod(argv[3]) : config->getDouble("bench_rate", options.rate);
+            options.concurrency = argc > 4 ? std::stoi(argv[4]) : config->getInt("bench_concurrency", options.concurrency);
+            options.requests = config->getSize("bench_requests", options.requests);
+            options.durationSec = config->getDouble("bench_duration_sec", options.durationSec);
+            options.timeoutMs = config->getInt("bench_timeout_ms", options.timeoutMs);
+            string queryLogPath = argc > 2 ? argv[2] : config->get("bench_query_log", "./data/synthetic_queries.txt");
+            string reportPath = config->get("bench_report_path", "./bench_server_result.json");
+
+            LOG_INFO("=== Replaying Query Log ===");
+            LoadGenerator generator(options);
+            if (generator.loadQueries(queryLogPath) == 0) {
+                return 1;
+            }
+            LoadReport report = generator.run();
+            report.log();
+
+            string json;
+            report.toJson(json);
+            std::ofstream ofs(reportPath);
+            ofs << json << "\n";
+            LOG_INFO("Report written to " + reportPath);
+            return report.completed > 0 ? 0 : 1;
+        }
+
         // 初始化分词工具
         auto splitTool = make_shared<JiebaSplitTool>(
             config->get("dict_path"),
@@ -66,32 +142,48 @@ int main(int argc, char* argv[]) {
         if (mode == "build") {
             // 构建索引模式
             LOG_INFO("=== Building Index ===");
+            BuildProfiler* profiler = BuildProfiler::getInstance();
+            profiler->begin();
 
-            // 1. 加载网页库
+            // 1. 加载网页库（读文件、抽取与分词在内部分别计时）
             PageLib pageLib(config->get("data_path"), splitTool.get());
             pageLib.load();
 
             // 2. 预处理（去重）
+            PhaseTimer dedupTimer(PHASE_DEDUP);
             PageLibPreprocessor preprocessor(pageLib.getPages(), splitTool.get());
             preprocessor.deduplicate();
+            dedupTimer.stop();
 
             auto& processedPages = preprocessor.getProcessedPages();
             LOG_INFO("After deduplication: " + std::to_string(processedPages.size()) + " pages");
+            profiler->setIndexedDocs(processedPages.size());
 
             // 3. 构建倒排索引
+            PhaseTimer invertTimer(PHASE_INVERT);
             auto index = make_shared<InvertIndex>();
             index->build(processedPages);
+            invertTimer.stop();
 
             // 4. 存储索引
-            index->store(config->get("index_path"));
+            {
+                PhaseTimer timer(PHASE_STORE);
+                index->store(config->get("index_path"));
+            }
 
             // 5. 构建词典（用于关键词推荐）
             LOG_INFO("=== Building Dictionary ===");
+            PhaseTimer dictTimer(PHASE_DICT);
             auto dictProducer = make_shared<DictProducer>(splitTool.get());
             dictProducer->build(processedPages);
-            dictProducer->storeDict(config->get("dict_path_output"));
-            dictProducer->storeIndex(config->get("dict_index_path"));
+            dictTimer.stop();
+            {
+                PhaseTimer timer(PHASE_STORE);
+                dictProducer->storeDict(config->get("dict_path_output"));
+                dictProducer->storeIndex(config->get("dict_index_path"));
+            }
 
+            PhaseTimer storeTimer(PHASE_STORE);
             // 6. 存储网页库（用于搜索时获取标题、摘要）
             LOG_INFO("=== Storing Page Library ===");
             pageLib.store(config->get("pagelib_path"));
@@ -100,9 +192,67 @@ int main(int argc, char* argv[]) {
             LOG_INFO("=== Storing Separated Format (for lite mode) ===");
             string metaPath = config->get("pagelib_path") + ".meta";
             string contentPath = config->get("pagelib_path") + ".content";
-            pageLib.storeSeparated(metaPath, contentPath);
+            string segPath = config->get("pagelib_path") + ".seg";
+            pageLib.storeSeparated(metaPath, contentPath, segPath);
+            storeTimer.stop();
 
             LOG_INFO("=== Index Build Complete ===");
+            profiler->report(config->get("build_profile_path", "./data/build_profile.json"));
+
+        } else if (mode == "compare-index") {
+            // 排序回归对比：A 为基准；B 为另一份索引，或 "termcache" 表示同一份索引开启热词缓存
+            string pathA = argc > 2 ? argv[2] : config->get("index_path");
+            string pathB = argc > 3 ? argv[3] : "termcache";
+            string queryLogPath = argc > 4 ? argv[4] : config->get("compare_query_log", "./data/synthetic_queries.txt");
+            size_t maxQueries = config->getSize("compare_max_queries", 5000);
+            int topK = config->getInt("compare_top_k", 20);
+
+            // 取日志中的不同查询，按首次出现顺序
+            vector<string> queries;
+            vector<vector<string>> tokenized;
+            std::ifstream ifs(queryLogPath);
+            if (!ifs) {
+                LOG_ERROR("Cannot open query log: " + queryLogPath);
+                return 1;
+            }
+            std::unordered_set<string> seen;
+            string line;
+            while (queries.size() < maxQueries && std::getline(ifs, line)) {
+                if (!line.empty() && seen.insert(line).second) {
+                    queries.push_back(line);
+                    tokenized.push_back(splitTool->cut(line));
+                }
+            }
+            LOG_INFO("Loaded " + std::to_string(queries.size()) + " distinct queries from " + queryLogPath);
+
+            auto indexA = make_shared<InvertIndex>();
+            indexA->load(pathA);
+            auto indexB = make_shared<InvertIndex>();
+            string labelB = pathB;
+            if (pathB == "termcache") {
+                indexB->load(pathA);
+                indexB->enableTermCache(config->getSize("term_cache_size", 512),
+                                        config->getSize("pair_cache_size", 0),
+                                        config->getInt("term_cache_admit", 3),
+                                        config->getSize("term_cache_prefix", 1000),
+                                        config->getSize("term_cache_min_postings", 1024));
+                labelB = pathA + " (term cache)";
+            } else {
+                indexB->load(pathB);
+            }
+
+            RankingComparator comparator(indexA.get(), pathA, indexB.get(), labelB);
+            ComparisonReport report = comparator.compare(queries, tokenized, topK,
+                                                         config->getInt("compare_warmup_rounds", 3));
+            report.log();
+
+            string reportPath = config->get("compare_report_path", "./compare_result.json");
+            string json;
+            report.toJson(json);
+            std::ofstream ofs(reportPath);
+            ofs << json << "\n";
+            LOG_INFO("Report written to " + reportPath);
+            return report.identical == report.queries ? 0 : 2;
 
         } else if (mode == "server" || mode == "server-lite") {
             bool useLiteMode = (mode == "server-lite");
@@ -117,6 +267,15 @@ int main(int argc, char* argv[]) {
             auto index = make_shared<InvertIndex>();
             index->load(config->get("index_path"));
 
+            size_t termCacheSize = config->getSize("term_cache_size", 0);
+            if (termCacheSize > 0) {
+                index->enableTermCache(termCacheSize,
+                                       config->getSize("pair_cache_size", 0),
+                                       config->getInt("term_cache_admit", 3),
+                                       config->getSize("term_cache_prefix", 1000),
+                                       config->getSize("term_cache_min_postings", 1024));
+            }
+
             // 2. 加载网页库
             LOG_INFO("Loading page library...");
 
@@ -159,15 +318,28 @@ int main(int argc, char* argv[]) {
 
             // 4. 启动服务
             string ip = config->get("server_ip");
-            int port = std::stoi(config->get("server_port"));
+            int port = config->getInt("server_port", 8080);
+
+            // 0 表示使用 workflow 默认线程数
+            SearchServer::configureThreads(config->getInt("compute_threads", 0),
+                                           config->getInt("poller_threads", 0),
+                                           config->getInt("handler_threads", 0));
 
             SearchServer server(ip, port, index, splitTool.get());
-            g_server = &server;
 
             if (useLiteMode) {
-                server.setPageLibLite(pageMeta, contentFilePath);
+                size_t mmapLimit = config->getSize("content_mmap_limit_mb", ContentStore::DEFAULT_MMAP_LIMIT >> 20) << 20;
+                server.setPageLibLite(pageMeta, contentFilePath, mmapLimit,
+                                      config->get("pagelib_path") + ".seg");
+                // 服务持有自己的副本，释放这里的一份，避免元数据常驻两份
+                unordered_map<int, WebPageMeta>().swap(pageMeta);
+
+                if (config->getBool("async_snippet", false)) {
+                    server.setAsyncSnippet(true, config->getInt("snippet_deadline_ms", 50));
+                }
             } else {
                 server.setPageLib(pageMap);
+                map<int, shared_ptr<WebPage>>().swap(pageMap);
             }
 
             if (dictProducer) {
@@ -177,13 +349,51 @@ int main(int argc, char* argv[]) {
                 server.setRecommender(recommender);
             }
 
-            string cacheSizeStr = config->get("cache_size");
-            if (!cacheSizeStr.empty()) {
-                server.setCacheCapacity(std::stoul(cacheSizeStr));
+            int admissionMax = config->getInt("admission_max_concurrent", 0);
+            if (admissionMax > 0) {
+                server.setAdmissionControl(admissionMax,
+                                           config->getInt("admission_max_queue", 64),
+                                           config->getInt("request_deadline_ms", 200));
+            }
+
+            if (config->has("ranked_cache_size")) {
+                server.setRankedListCache(config->getSize("ranked_cache_size", 0),
+                                          config->getInt("ranked_list_depth", 200));
+            }
+
+            if (config->has("slow_query_threshold_ms")) {
+                server.setSlowQueryLog(config->get("slow_query_log_path"),
+                                       config->getInt("slow_query_threshold_ms", 0),
+                                       config->getDouble("slow_query_sample_rate", 0),
+                                       config->getSize("slow_query_capacity", 256));
+            }
+
+            if (config->has("msearch_max_queries")) {
+                server.setMaxBatchQueries(config->getSize("msearch_max_queries", 0));
+            }
+
+            if (config->has("cache_size")) {
+                server.setCacheCapacity(config->getSize("cache_size", 0));
+            }
+
+            if (config->has("snippet_cache_size")) {
+                server.setSnippetCacheCapacity(config->getSize("snippet_cache_size", 0));
+            }
+
+            string snapshotPath = config->get("cache_snapshot_path");
+            string queryLogPath = config->get("query_log_path");
+            if (!snapshotPath.empty() || !queryLogPath.empty()) {
+                server.setCacheWarmup(snapshotPath, queryLogPath,
+                                      config->getInt("cache_snapshot_interval", 60),
+                                      config->getSize("warmup_queries", 500),
+                                      config->getInt("warmup_threads", 4));
             }
 
+            std::atomic<bool> serverDone{false};
+            std::thread signalWatcher(watchSignals, &server, &serverDone);
             server.start();
-            g_server = nullptr;
+            serverDone = true;
+            signalWatcher.join();
 
         } else {
             printUsage(argv[0]);
@@ -0,0 +1,154 @@
+// 游标翻页一致性测试：make test 运行，失败时返回非 0
+// 排序列表（首页）可能来自阈值算法，游标续查总是完整遍历；两条路径的得分必须逐位相同，
+// 否则边界文档在翻页时会重复或丢失。分别用不带 / 带热词缓存的索引生成排序列表，
+// 在列表中取若干位置作为游标，检查续查结果与列表剩余部分完全一致
+
+#include "SplitTool.h"
+#include "WebPage.h"
+#include "InvertIndex.h"
+#include "Logger.h"
+#include <iostream>
+#include <random>
+#include <memory>
+#include <algorithm>
+
+using std::shared_ptr;
+using std::make_shared;
+
+static const uint64_t SEED = 20240617;
+static const size_t CORPUS_DOCS = 10000;
+static const size_t VOCAB_SIZE = 2000;
+static const int QUERY_COUNT = 400;
+static const int RANKED_DEPTH = 30;
+static const int PAGE_SIZE = 5;
+
+// 按空格切分（测试语料中词之间以空格分隔）
+class WhitespaceSplitTool : public SplitTool {
+public:
+    vector<string> cut(const string& sentence) override {
+        vector<string> words;
+        size_t pos = 0;
+        while (pos < sentence.size()) {
+            size_t end = sentence.find(' ', pos);
+            if (end == string::npos) end = sentence.size();
+            if (end > pos) {
+                words.emplace_back(sentence, pos, end - pos);
+            }
+            pos = end + 1;
+        }
+        return words;
+    }
+};
+
+static int failures = 0;
+
+static void expect(bool ok, const string& what, const vector<string>& query) {
+    if (ok) return;
+    failures++;
+    string words;
+    for (const auto& w : query) {
+        words += w + " ";
+    }
+    std::cerr << "FAIL: " << what << " [query: " << words << "]\n";
+}
+
+static bool sameList(const vector<pair<int, double>>& a, const vector<pair<int, double>>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        // 得分逐位比较，不允许误差
+        if (a[i].first != b[i].first || a[i].second != b[i].second) return false;
+    }
+    return true;
+}
+
+// 从排序列表的第 cut 项之后续查一页，应与列表中对应的一段相同（列表不足一页时只比较已有部分）
+static void checkContinuation(InvertIndex& index, const vector<string>& query,
+                              const vector<pair<int, double>>& ranked, const string& label) {
+    for (size_t cut = PAGE_SIZE; cut < ranked.size(); cut += PAGE_SIZE) {
+        const auto& last = ranked[cut - 1];
+        auto page = index.searchAfter(query, PAGE_SIZE, last.second, last.first);
+        size_t end = std::min(cut + PAGE_SIZE, ranked.size());
+        vector<pair<int, double>> expected(ranked.begin() + cut, ranked.begin() + end);
+        page.resize(std::min(page.size(), expected.size()));
+        expect(sameList(page, expected), label + ": continuation after #" + std::to_string(cut), query);
+    }
+}
+
+int main() {
+    Logger::getInstance()->init("conf/log4cpp.properties");
+
+    // 词频服从 Zipf 分布：少数高频词的倒排表足够长，能进入热词缓存
+    std::mt19937_64 rng(SEED);
+    vector<string> vocab;
+    for (size_t i = 0; i < VOCAB_SIZE; ++i) {
+        vocab.push_back("w" + std::to_string(i));
+    }
+    vector<double> cdf(VOCAB_SIZE);
+    double sum = 0;
+    for (size_t i = 0; i < VOCAB_SIZE; ++i) {
+        sum += 1.0 / (i + 1);
+        cdf[i] = sum;
+    }
+    std::uniform_real_distribution<double> uniform(0, sum);
+    auto zipfWord = [&]() -> const string& {
+        size_t rank = std::upper_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+        return vocab[std::min(rank, VOCAB_SIZE - 1)];
+    };
+
+    WhitespaceSplitTool splitTool;
+    vector<shared_ptr<WebPage>> pages;
+    std::uniform_int_distribution<int> docLen(20, 120);
+    for (size_t d = 0; d < CORPUS_DOCS; ++d) {
+        string content;
+        int words = docLen(rng);
+        for (int i = 0; i < words; ++i) {
+            content += zipfWord();
+            content += ' ';
+        }
+        string doc = "<doc><docid>" + std::to_string(d + 1) + "</docid><url>http://test.local/"
+                     + std::to_string(d + 1) + "</url><title>t</title><content>" + content + "</content></doc>";
+        pages.push_back(make_shared<WebPage>(doc, &splitTool));
+    }
+
+    InvertIndex plain, cached;
+    plain.build(pages);
+    cached.build(pages);
+    // 准入阈值 1、前缀较短：首次查询即走阈值算法，覆盖提前终止与补全两种情况
+    cached.enableTermCache(256, 512, 1, 64, 64);
+
+    size_t thresholdRuns = 0, completedRuns = 0;
+    vector<string> batchPeer;    // 与当前查询同批解析的上一个查询
+    for (int q = 0; q < QUERY_COUNT; ++q) {
+        vector<string> query;
+        int n = 1 + rng() % 6;
+        for (int i = 0; i < n; ++i) {
+            query.push_back(rng() % 4 == 0 ? vocab[rng() % VOCAB_SIZE] : vocab[rng() % 40]);
+        }
+        if (rng() % 4 == 0) {
+            query.push_back(query.front());    // 重复词
+        }
+
+        auto expected = plain.search(query, RANKED_DEPTH);
+        SearchStats stats;
+        auto ranked = cached.search(query, RANKED_DEPTH, &stats);
+        if (stats.path == "threshold") {
+            thresholdRuns++;
+            completedRuns += stats.fallback ? 1 : 0;
+        }
+        expect(sameList(ranked, expected), "threshold ranked list differs from exhaustive", query);
+        // 批量搜索共享预先解析的词项，结果也必须相同
+        auto batched = cached.search(query, RANKED_DEPTH, cached.resolveTerms({query, batchPeer}));
+        expect(sameList(batched, expected), "batched ranked list differs from exhaustive", query);
+        batchPeer = query;
+
+        checkContinuation(plain, query, expected, "exhaustive");
+        checkContinuation(cached, query, ranked, "threshold");
+    }
+
+    // 预判可能把查询全部转给完整遍历，那样测试就没有覆盖阈值算法
+    expect(thresholdRuns > 0, "no query took the threshold path", {});
+
+    std::cout << QUERY_COUNT << " queries, " << thresholdRuns << " via threshold path ("
+              << completedRuns << " completed after budget), " << failures << " failures\n";
+    return failures == 0 ? 0 : 1;
+}